@@ -9,6 +9,16 @@
 // pulse_func to determine the new values of those variables. The FIFO lets the ISR stay
 // just far enough ahead so the information is always ready, but not so far ahead to cause
 // latency problems.
+//
+// The I2S_DMA engine instead feeds the FIFO by DMA from a ring of sample buffers.  A
+// task renders each buffer, calling pulse_func for each step event and filling the gaps
+// between pulses in bulk, and the DMA end-of-frame ISR only recycles the descriptors.
+// That costs one task wakeup per buffer rather than one interrupt per FIFO refill, at the
+// price of latency: the pulses leave the ring a few milliseconds after pulse_func ran.
+// Probe and limit switches are latched by pulse_func, so with this engine they are latched
+// when a buffer is rendered, not when its pulses are output.  While low latency is set,
+// for homing and probing, the task renders only one buffer ahead of the DMA, which bounds
+// that error to the steps of two buffers.  I2S_STATIC and I2S_STREAM both use the FIFO engine.
 
 #include "Driver/step_engine.h"
 #include "Driver/i2s_out.h"
@@ -22,6 +32,9 @@
 #include <esp_attr.h>  // IRAM_ATTR
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <string.h>  // memcpy()
 
 #include <driver/periph_ctrl.h>
 #include <rom/lldesc.h>
@@ -147,12 +160,22 @@ static int i2s_out_start() {
 // is about half of the modulation period of a laser that
 // is modulated at 20 kHZ.
 
+// - In low latency mode, for homing and probing, the threshold
+// is halved, so a limit or probe switch stops the pulses sooner
+// at the cost of less tolerance for interrupt latency.
+
 #define FIFO_LENGTH (I2S_TX_DATA_NUM + 1)
 #define FIFO_THRESHOLD (FIFO_LENGTH / 4)
+#define FIFO_THRESHOLD_LOW_LATENCY (FIFO_LENGTH / 8)
 #define FIFO_REMAINING (FIFO_LENGTH - FIFO_THRESHOLD)
 #define FIFO_RELOAD 8
 
 static bool timer_running = false;
+static bool stream_mode   = false;  // The I2S_DMA engine owns the FIFO through DMA
+
+// Stream ring: STREAM_BUFFERS descriptors of STREAM_SAMPLES samples each
+#define STREAM_BUFFERS 4
+#define STREAM_SAMPLES 512
 
 void i2s_out_delay() {
     // Empirically, FIFO_LENGTH/2 seems to be enough, but we use
@@ -160,6 +183,10 @@ void i2s_out_delay() {
     // typically only when setting up TMC drivers, so the extra
     // delay does not affect the performance significantly.
     uint32_t wait_counts = FIFO_LENGTH;
+    if (stream_mode) {
+        // The change has to be rendered and then pass through the whole ring
+        wait_counts += (STREAM_BUFFERS + 1) * STREAM_SAMPLES;
+    }
     delay_us(i2s_frame_us * wait_counts);
 }
 
@@ -171,7 +198,7 @@ void IRAM_ATTR i2s_out_write(pinnum_t pin, uint8_t val) {
         i2s_out_port_data &= ~bit;
     }
 
-    if (!timer_running) {
+    if (!timer_running && !stream_mode) {
         // Direct write to the I2S FIFO in case the pulse timer is not running
         I2S0.fifo_wr = i2s_out_port_data;
     }
@@ -465,6 +492,11 @@ static IRAM_ATTR void set_step_pin(int pin, int level) {
     }
 }
 
+// The pins are bits of the I2S output word, so all of them change at once
+static IRAM_ATTR void write_step_pins(uint32_t pins, uint32_t levels) {
+    _pulse_data = (_pulse_data & ~pins) | (levels & pins);
+}
+
 static void IRAM_ATTR finish_step() {}
 
 static int IRAM_ATTR start_unstep() {
@@ -474,6 +506,10 @@ static int IRAM_ATTR start_unstep() {
 // Not called since start_unstep() returns 1
 static IRAM_ATTR void finish_unstep() {}
 
+static void set_low_latency(bool on) {
+    I2S0.fifo_conf.tx_data_num = on ? FIFO_THRESHOLD_LOW_LATENCY : FIFO_THRESHOLD;
+}
+
 static uint32_t max_pulses_per_sec() {
     return 1000000 / (2 * _pulse_counts * i2s_frame_us);
 }
@@ -493,7 +529,253 @@ step_engine_t i2s_engine = {
     max_pulses_per_sec,
     set_timer_ticks,
     start_timer,
-    stop_timer
+    stop_timer,
+    write_step_pins,
+    set_low_latency
 };
 // clang-format on
 REGISTER_STEP_ENGINE(I2S, &i2s_engine);
+
+// I2S_DMA engine
+
+static lldesc_t  stream_desc[STREAM_BUFFERS];
+static uint32_t* stream_buf[STREAM_BUFFERS];
+static uint32_t* stream_idle;         // Sent in place of a buffer that was not rendered in time
+static uint32_t  stream_idle_data;    // i2s_out_port_data when stream_idle was filled
+static uint32_t  _stream_dir_counts;  // Samples of direction setup before the next pulse
+static uint32_t  _dir_delay_counts;
+
+static volatile uint32_t stream_consumed  = 0;               // Buffers that the DMA has finished, counted by the ISR
+static uint32_t          stream_rendered  = 0;               // Buffers that the render task has filled
+static volatile uint32_t stream_underruns = 0;               // Buffers that the DMA replaced with the idle buffer
+static volatile uint32_t stream_ahead     = STREAM_BUFFERS;  // Limit on stream_rendered - stream_consumed
+
+static TaskHandle_t render_task = NULL;
+
+// The render task runs on the core of the segment prep task, above it, so
+// that it can fill a buffer in the time the DMA takes to send one
+#define RENDER_TASK_CORE 1
+#define RENDER_TASK_PRIORITY 10
+
+static void IRAM_ATTR fill(uint32_t* buf, uint32_t n, uint32_t data) {
+    while (n--) {
+        *buf++ = data;
+    }
+}
+
+// Fills one buffer with the samples of the pulses and the gaps between them.
+// This is i2s_isr() writing to memory instead of to the FIFO.
+static void IRAM_ATTR render(uint32_t* buf) {
+    uint32_t pulse_data             = _pulse_data;
+    uint32_t remaining_pulse_counts = _remaining_pulse_counts;
+    uint32_t remaining_delay_counts = _remaining_delay_counts;
+
+    uint32_t n = 0;
+    while (n < STREAM_SAMPLES) {
+        uint32_t room = STREAM_SAMPLES - n;
+        if (_stream_dir_counts) {
+            uint32_t k = _stream_dir_counts < room ? _stream_dir_counts : room;
+            fill(buf + n, k, i2s_out_port_data);
+            n += k;
+            _stream_dir_counts -= k;
+        } else if (remaining_pulse_counts) {
+            uint32_t k = remaining_pulse_counts < room ? remaining_pulse_counts : room;
+            fill(buf + n, k, pulse_data);
+            n += k;
+            remaining_pulse_counts -= k;
+        } else if (remaining_delay_counts) {
+            uint32_t k = remaining_delay_counts < room ? remaining_delay_counts : room;
+            fill(buf + n, k, i2s_out_port_data);
+            n += k;
+            remaining_delay_counts -= k;
+        } else if (!timer_running) {
+            fill(buf + n, room, i2s_out_port_data);
+            break;
+        } else {
+            _pulse_data = i2s_out_port_data;
+
+            _pulse_func();
+
+            pulse_data             = _pulse_data;
+            remaining_pulse_counts = pulse_data == i2s_out_port_data ? 0 : _pulse_counts;
+            uint32_t used          = remaining_pulse_counts + _stream_dir_counts;
+            remaining_delay_counts = _delay_counts > used ? _delay_counts - used : 0;
+        }
+    }
+
+    _remaining_pulse_counts = remaining_pulse_counts;
+    _remaining_delay_counts = remaining_delay_counts;
+}
+
+// The DMA has read the whole buffer of a descriptor into the FIFO.  Point the
+// descriptor at the idle buffer until the render task refills it, so a late
+// render delays the pulses instead of sending the old ones again.
+static void IRAM_ATTR i2s_stream_isr() {
+    uint32_t finished;
+    i2s_ll_tx_get_eof_des_addr(&I2S0, &finished);
+    ((lldesc_t*)finished)->buf = (uint8_t*)stream_idle;
+    ++stream_consumed;
+
+    i2s_ll_clear_intr_status(&I2S0, I2S_OUT_EOF_INT_CLR);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(render_task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void render_loop(void* unused) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (stream_idle_data != i2s_out_port_data) {
+            stream_idle_data = i2s_out_port_data;
+            fill(stream_idle, STREAM_SAMPLES, stream_idle_data);
+        }
+
+        // Fill the buffers that the DMA has finished, in ring order, staying strictly
+        // ahead of the one it is sending now.  If the task fell so far behind that the
+        // DMA sent idle buffers in place of unrendered ones, count them as underruns and skip
+        // them, and cut short a pulse that was split across them so that it cannot turn into two.
+        uint32_t consumed = stream_consumed;
+        if (stream_rendered <= consumed) {
+            stream_underruns += consumed + 1 - stream_rendered;
+            stream_rendered         = consumed + 1;
+            _remaining_pulse_counts = 0;
+        }
+        while (stream_rendered - consumed < stream_ahead) {
+            int i = stream_rendered % STREAM_BUFFERS;
+            render(stream_buf[i]);
+            // The DMA keeps going during render().  If it has reached this slot, it is sending
+            // the idle buffer there, so move the rendered pulses to the slot after that one
+            // rather than lose them.
+            while (stream_rendered <= (consumed = stream_consumed)) {
+                stream_underruns += consumed + 1 - stream_rendered;
+                stream_rendered = consumed + 1;
+                int next        = stream_rendered % STREAM_BUFFERS;
+                if (next != i) {
+                    memcpy(stream_buf[next], stream_buf[i], STREAM_SAMPLES * sizeof(uint32_t));
+                    i = next;
+                }
+            }
+            stream_desc[i].buf = (uint8_t*)stream_buf[i];
+            ++stream_rendered;
+        }
+    }
+}
+
+static uint32_t init_stream_engine(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t frequency, bool (*callback)(void)) {
+    _pulse_func = callback;
+
+    if (pulse_us < i2s_frame_us) {
+        pulse_us = i2s_frame_us;
+    }
+    if (pulse_us > I2S_MAX_USEC_PER_PULSE) {
+        pulse_us = I2S_MAX_USEC_PER_PULSE;
+    }
+    _dir_delay_us     = dir_delay_us;
+    _dir_delay_counts = (dir_delay_us + i2s_frame_us - 1) / i2s_frame_us;
+    _pulse_counts     = (pulse_us + i2s_frame_us - 1) / i2s_frame_us;
+    _tick_divisor     = frequency * i2s_frame_us / 1000000;
+
+    _remaining_pulse_counts = 0;
+    _remaining_delay_counts = 0;
+    _stream_dir_counts      = 0;
+    set_timer_ticks(100);
+
+    const size_t bytes = STREAM_SAMPLES * sizeof(uint32_t);
+    stream_idle_data   = i2s_out_port_data;
+    stream_idle        = heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+    fill(stream_idle, STREAM_SAMPLES, stream_idle_data);
+    for (int i = 0; i < STREAM_BUFFERS; i++) {
+        stream_buf[i] = heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+        fill(stream_buf[i], STREAM_SAMPLES, stream_idle_data);
+
+        lldesc_t* d     = &stream_desc[i];
+        d->size         = bytes;
+        d->length       = bytes;
+        d->offset       = 0;
+        d->sosf         = 0;
+        d->eof          = 1;  // Interrupt at the end of each buffer
+        d->owner        = 1;
+        d->buf          = (uint8_t*)stream_buf[i];
+        d->qe.stqe_next = &stream_desc[(i + 1) % STREAM_BUFFERS];
+    }
+    stream_consumed = 0;
+    stream_rendered = STREAM_BUFFERS;
+
+    xTaskCreatePinnedToCore(render_loop, "i2s_render", 4096, NULL, RENDER_TASK_PRIORITY, &render_task, RENDER_TASK_CORE);
+
+    // Switch the I2S peripheral from the FIFO to DMA
+    stream_mode = true;
+    i2s_ll_tx_stop(&I2S0);
+    i2s_ll_tx_stop_link(&I2S0);
+    i2s_out_reset_tx_rx();
+    i2s_ll_tx_reset_dma(&I2S0);
+    i2s_out_reset_fifo_without_lock();
+    i2s_ll_enable_dma(&I2S0, true);
+
+    esp_intr_alloc_intrstatus(ETS_I2S0_INTR_SOURCE,
+                              ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL3,
+                              (uint32_t)i2s_ll_get_intr_status_reg(&I2S0),
+                              I2S_OUT_EOF_INT_CLR_M,
+                              i2s_stream_isr,
+                              NULL,
+                              NULL);
+    i2s_ll_clear_intr_status(&I2S0, I2S_OUT_EOF_INT_CLR);
+    i2s_ll_enable_intr(&I2S0, I2S_OUT_EOF_INT_ENA, 1);
+
+    i2s_ll_tx_start_link(&I2S0, (uint32_t)&stream_desc[0]);
+    i2s_ll_tx_start(&I2S0);
+
+    return _pulse_counts * i2s_frame_us;
+}
+
+// The direction change goes into the stream as setup samples ahead of the pulse
+static IRAM_ATTR void finish_stream_dir() {
+    _stream_dir_counts = _dir_delay_counts ? _dir_delay_counts : 1;
+}
+
+static uint32_t stream_underrun_count() {
+    return stream_underruns;
+}
+
+// Render only one buffer ahead of the one the DMA is sending, so that the
+// switches that pulse_func latches are at most two buffers behind the output.
+// Buffers already rendered stay queued; the ring drains to the new depth.
+static void set_stream_low_latency(bool on) {
+    stream_ahead = on ? 2 : STREAM_BUFFERS;
+}
+
+// The render task picks these up at its next pulse_func call
+static void IRAM_ATTR start_stream_timer() {
+    timer_running = true;
+}
+
+static void IRAM_ATTR stop_stream_timer() {
+    timer_running = false;
+}
+
+// clang-format off
+step_engine_t i2s_dma_engine = {
+    "I2S_DMA",
+    init_stream_engine,
+    init_step_pin,
+    set_dir_pin,
+    finish_stream_dir,
+    start_step,
+    set_step_pin,
+    finish_step,
+    start_unstep,
+    finish_unstep,
+    max_pulses_per_sec,
+    set_timer_ticks,
+    start_stream_timer,
+    stop_stream_timer,
+    write_step_pins,
+    set_stream_low_latency,
+    stream_underrun_count
+};
+// clang-format on
+REGISTER_STEP_ENGINE(I2S_DMA, &i2s_dma_engine);
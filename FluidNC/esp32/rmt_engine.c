@@ -91,6 +91,16 @@ static IRAM_ATTR void set_step_pin(int pin, int level) {
 #endif
 }
 
+// The pins are RMT channel numbers.  Each channel times its own pulse,
+// so the levels do not matter.
+static IRAM_ATTR void write_step_pins(uint32_t pins, uint32_t levels) {
+    for (int pin = 0; pins; pin++, pins >>= 1) {
+        if (pins & 1) {
+            set_step_pin(pin, 1);
+        }
+    }
+}
+
 // This is a noop because the RMT channels do everything
 static IRAM_ATTR void finish_step() {}
 
@@ -142,7 +152,8 @@ static step_engine_t engine = {
     max_pulses_per_sec,
     set_timer_ticks,
     start_timer,
-    stop_timer
+    stop_timer,
+    write_step_pins
 };
 
 REGISTER_STEP_ENGINE(RMT, &engine);
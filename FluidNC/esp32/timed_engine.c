@@ -9,6 +9,7 @@
 #include "Driver/StepTimer.h"
 #include <esp32-hal-gpio.h>
 #include <esp_attr.h>  // IRAM_ATTR
+#include <soc/gpio_struct.h>
 
 static uint32_t _pulse_delay_us;
 static uint32_t _dir_delay_us;
@@ -36,6 +37,13 @@ static void IRAM_ATTR finish_dir() {
 
 static void IRAM_ATTR start_step() {}
 
+// Pins 0-31 are all in the low GPIO output register, so the set and
+// clear registers change any number of them with two writes
+static void IRAM_ATTR write_step_pins(uint32_t pins, uint32_t levels) {
+    GPIO.out_w1ts = pins & levels;
+    GPIO.out_w1tc = pins & ~levels;
+}
+
 // Instead of waiting here for the step end time, we mark when the
 // step pulse should end, then return.  The stepper code can then do
 // some work that is overlapped with the pulse time.  The spin loop
@@ -84,7 +92,8 @@ static step_engine_t engine = {
     max_pulses_per_sec,
     set_timer_ticks,
     start_timer,
-    stop_timer
+    stop_timer,
+    write_step_pins
 };
 
 REGISTER_STEP_ENGINE(Timed, &engine);
@@ -0,0 +1,46 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Timing probes for the stages of the motion pipeline.  They are compiled
+// in only when MOTION_BENCHMARK is defined, as it is for the host simulator.
+// The platform supplies the clock and collects the results, so firmware
+// builds carry no overhead.
+
+#pragma once
+
+#include <stdint.h>
+
+enum class BenchStage : int {
+    PlanBufferLine = 0,
+    PlannerRecalculate,
+    PrepBuffer,
+    Count,
+};
+
+#ifdef MOTION_BENCHMARK
+
+// Returns a timestamp in nanoseconds from a clock that does not advance
+// while the calling thread is descheduled
+uint64_t bench_start();
+
+// Records one call to stage that began at start and did items units of work.
+// Calls that did no work are not recorded.
+void bench_end(BenchStage stage, uint64_t start, uint32_t items);
+
+class BenchProbe {
+    BenchStage _stage;
+    uint64_t   _start;
+
+public:
+    uint32_t items = 0;
+
+    BenchProbe(BenchStage stage) : _stage(stage), _start(bench_start()) {}
+    ~BenchProbe() { bench_end(_stage, _start, items); }
+};
+
+#    define BENCH_PROBE(stage) BenchProbe bench_probe_(BenchStage::stage)
+#    define BENCH_ITEMS(n) bench_probe_.items += (n)
+#else
+#    define BENCH_PROBE(stage)
+#    define BENCH_ITEMS(n)
+#endif
@@ -62,6 +62,20 @@ typedef struct step_engine {
     // Stop the pulse event timer
     void (*stop_timer)();
 
+    // Optional: set several step pins at once.  Each bit of pins selects
+    // the pin whose init_step_pin() number is that bit number, and the
+    // same bit of levels is its new state.  If this is NULL, or a step
+    // pin number is above 31, Stepping.cpp calls set_step_pin() per pin.
+    void (*write_step_pins)(uint32_t pins, uint32_t levels);
+
+    // Optional: trade step generation headroom for a shorter delay between
+    // pulse_func() and the pulses, while homing and probing
+    void (*set_low_latency)(bool on);
+
+    // Optional: the number of times that the engine had to output idle samples
+    // because the pulses for that time were not ready, which delays them
+    uint32_t (*underruns)();
+
     // Link to next engine in the list of registered stepping engines
     struct step_engine* link;
 } step_engine_t;
@@ -0,0 +1,42 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  PWM outputs for the host simulator.  The period is computed the same
+  way as for the ESP32 LEDC controller so spindle speed maps produce the
+  same duty values; the duty is only recorded.
+*/
+
+#include "Driver/PwmPin.h"
+
+static uint32_t pwm_duty[64];
+
+// Calculate the highest PwmPin precision in bits for the desired frequency
+// 80,000,000 (APB Clock) = freq * maxCount
+static uint8_t calc_pwm_precision(uint32_t frequency) {
+    if (frequency == 0) {
+        frequency = 1;  // Limited elsewhere but just to be safe...
+    }
+
+    const uint8_t  ledcMaxBits = 20;
+    const uint32_t apbFreq     = 80000000;
+    const uint32_t maxCount    = apbFreq / frequency;
+    for (uint8_t bits = 2; bits <= ledcMaxBits; ++bits) {
+        if ((1u << bits) > maxCount) {
+            return bits - 1;
+        }
+    }
+
+    return ledcMaxBits;
+}
+
+PwmPin::PwmPin(int gpio, bool invert, uint32_t frequency) : _gpio(gpio), _frequency(frequency), _channel(gpio) {
+    _period = (1 << calc_pwm_precision(frequency)) - 1;
+    setDuty(0);
+}
+
+void PwmPin::setDuty(uint32_t duty) {
+    pwm_duty[_gpio & 63] = duty;
+}
+
+PwmPin::~PwmPin() {}
@@ -0,0 +1,20 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Used by AssertionFailed::create() on non-ESP32 builds
+
+#include <execinfo.h>
+#include <sstream>
+
+void DumpStackTrace(std::ostringstream& builder) {
+    void* frames[16];
+    int   n       = backtrace(frames, 16);
+    char** symbols = backtrace_symbols(frames, n);
+    if (!symbols) {
+        return;
+    }
+    for (int i = 1; i < n; i++) {
+        builder << std::endl << "  " << symbols[i];
+    }
+    free(symbols);
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "src/StartupLog.h"
+
+#include <string>
+
+// There is no panic-surviving RAM on the host, so the log only
+// covers the current run.
+static std::string _messages;
+
+void StartupLog::init() {
+    _messages.clear();
+}
+size_t StartupLog::write(uint8_t data) {
+    _messages += char(data);
+    return 1;
+}
+// cppcheck-suppress unusedFunction
+void StartupLog::dump(Channel& out) {
+    size_t start = 0;
+    while (start < _messages.length()) {
+        size_t end = _messages.find('\n', start);
+        if (end == std::string::npos) {
+            end = _messages.length();
+        }
+        std::string line = _messages.substr(start, end - start);
+        start            = end + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line.back() == ']') {
+            line.pop_back();
+        }
+        log_stream(out, line);
+    }
+}
+
+StartupLog::~StartupLog() {}
+
+StartupLog startupLog;
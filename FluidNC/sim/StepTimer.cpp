@@ -0,0 +1,105 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Virtual step timer for the host simulator.  A thread stands in for the
+// timer interrupt.  Each "interrupt" advances virtual time by the current
+// period and then calls the ISR callback, so the callback sees exactly the
+// sequence of periods that the hardware timer would produce.
+
+#include "Driver/StepTimer.h"
+#include "sim.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static uint32_t timer_frequency = 20000000;
+static bool (*timer_isr_callback)(void);
+
+static std::atomic<uint32_t> timer_ticks { 1 };
+static std::atomic<bool>     timer_running { false };
+static std::atomic<uint64_t> isr_ticks { 0 };
+static uint32_t              timer_starts = 0;  // Protected by timer_mutex
+
+static std::mutex              timer_mutex;
+static std::condition_variable timer_cv;
+
+static uint64_t nanos_to_ticks(uint64_t nanos) {
+    return uint64_t(double(nanos) * timer_frequency / 1e9);
+}
+
+static uint64_t ticks_to_nanos(uint64_t ticks) {
+    return uint64_t(double(ticks) * 1e9 / timer_frequency);
+}
+
+uint64_t sim_isr_ticks() {
+    return isr_ticks;
+}
+
+uint32_t sim_timer_frequency() {
+    return timer_frequency;
+}
+
+static void timer_task() {
+    while (true) {
+        uint32_t starts;
+        {
+            std::unique_lock<std::mutex> lock(timer_mutex);
+            timer_cv.wait(lock, [] { return timer_running.load(); });
+            starts = timer_starts;
+        }
+        uint64_t now = isr_ticks + timer_ticks;
+
+        // Pacing: sleep off any lead over the virtual clock, but only once
+        // it exceeds a millisecond so the sleep granularity of the host
+        // does not dominate.
+        uint64_t clock = nanos_to_ticks(sim_nanos());
+        if (now > clock && now - clock > timer_frequency / 1000) {
+            sim_sleep_nanos(ticks_to_nanos(now - clock));
+        }
+        isr_ticks = now;
+
+        // On the ESP32, returning false just leaves the alarm disabled, so
+        // a stepTimerStart() from the other core while the ISR is running
+        // still takes effect.  Do the same here.
+        if (!timer_isr_callback()) {
+            std::lock_guard<std::mutex> lock(timer_mutex);
+            if (timer_starts == starts) {
+                timer_running = false;
+            }
+        }
+    }
+}
+
+void stepTimerInit(uint32_t frequency, bool (*callback)(void)) {
+    timer_frequency    = frequency;
+    timer_isr_callback = callback;
+
+    std::thread(timer_task).detach();
+}
+
+void stepTimerSetTicks(uint32_t ticks) {
+    timer_ticks = ticks ? ticks : 1;
+}
+
+void stepTimerStart() {
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex);
+        if (!timer_running) {
+            // Time passes while the timer is stopped
+            uint64_t clock = nanos_to_ticks(sim_nanos());
+            if (clock > isr_ticks) {
+                isr_ticks = clock;
+            }
+        }
+        timer_ticks = 10;  // Interrupt very soon to start the stepping
+        ++timer_starts;
+        timer_running = true;
+    }
+    timer_cv.notify_one();
+}
+
+void stepTimerStop() {
+    timer_running = false;
+}
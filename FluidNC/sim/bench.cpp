@@ -0,0 +1,69 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Collects the motion pipeline timing probes from Driver/benchmark.h.
+// Times are CPU time of the calling thread, so the step ISR thread and the
+// other simulated tasks do not inflate them.  That makes the throughput
+// figures a measure of the cost of each stage on the host, independent of
+// how fast the simulated machine is moving.
+
+#include "Driver/benchmark.h"
+#include "sim.h"
+
+#include <cinttypes>
+#include <ctime>
+
+struct bench_stats_t {
+    const char* name;
+    const char* unit;
+    uint64_t    calls;
+    uint64_t    items;
+    uint64_t    total_ns;
+    uint64_t    worst_ns;
+};
+
+static bench_stats_t stats[int(BenchStage::Count)] = {
+    { "plan_buffer_line", "blocks" },
+    { "planner_recalculate", "passes" },
+    { "prep_buffer", "segments" },
+};
+
+uint64_t bench_start() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void bench_end(BenchStage stage, uint64_t start, uint32_t items) {
+    if (!items) {
+        return;
+    }
+    uint64_t ns = bench_start() - start;
+    auto&    s  = stats[int(stage)];
+    ++s.calls;
+    s.items += items;
+    s.total_ns += ns;
+    if (ns > s.worst_ns) {
+        s.worst_ns = ns;
+    }
+}
+
+void sim_bench_report(FILE* out) {
+    fprintf(out, "%-20s %10s %10s %10s %10s %10s %12s\n", "Stage", "Calls", "Items", "Total ms", "Mean us", "Worst us", "Items/sec");
+    for (auto& s : stats) {
+        if (!s.calls) {
+            fprintf(out, "%-20s %10d\n", s.name, 0);
+            continue;
+        }
+        fprintf(out,
+                "%-20s %10" PRIu64 " %10" PRIu64 " %10.3f %10.3f %10.3f %12.0f %s\n",
+                s.name,
+                s.calls,
+                s.items,
+                s.total_ns / 1e6,
+                s.total_ns / 1e3 / s.calls,
+                s.worst_ns / 1e3,
+                s.items * 1e9 / s.total_ns,
+                s.unit);
+    }
+}
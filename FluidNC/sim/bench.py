@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+# Runs the motion pipeline benchmark streams through the host simulator
+# and prints the per-stage timing for each one.  Compare the output
+# before and after a change to the planner or segment prep.
+#
+#   bench.py [-s speed] [program]
+#
+# program defaults to the sim environment build, .pio/build/sim/program
+
+import argparse
+import math
+import os
+import subprocess
+import sys
+
+here = os.path.dirname(os.path.abspath(__file__))
+tests = os.path.join(here, "..", "src", "tests")
+
+
+def surfacing():
+    # Zig-zag 3D finishing pass over a wavy surface, 0.2 mm segments
+    lines = ["G21 G90 G94", "G0 Z5", "G0 X0 Y0", "G1 Z0 F2000"]
+    for row in range(40):
+        y = row * 1.0
+        xs = range(201) if row % 2 == 0 else range(200, -1, -1)
+        for i in xs:
+            x = i * 0.2
+            z = 2 * math.sin(x / 5) * math.cos(y / 7)
+            lines.append("G1 X%.3f Y%.3f Z%.3f F3000" % (x, y, z))
+    lines.append("G0 Z5")
+    return "\n".join(lines) + "\n"
+
+
+def from_file(name):
+    with open(os.path.join(tests, name)) as f:
+        return f.read()
+
+
+streams = [
+    ("surfacing", surfacing),
+    ("arcs_arrows.nc", lambda: from_file("arcs_arrows.nc")),
+    ("raster_tree.nc", lambda: from_file("raster_tree.nc")),
+]
+
+parser = argparse.ArgumentParser()
+parser.add_argument("program", nargs="?", default=os.path.join(here, "..", "..", ".pio", "build", "sim", "program"))
+parser.add_argument("-s", "--speed", default="100", help="ratio of simulated time to real time")
+args = parser.parse_args()
+
+status = 0
+for name, stream in streams:
+    print("=== " + name)
+    run = subprocess.run(
+        [args.program, "-b", "-d", here, "-s", args.speed],
+        input=stream(),
+        stdout=subprocess.DEVNULL,
+        stderr=subprocess.PIPE,
+        universal_newlines=True,
+    )
+    print(run.stderr, end="")
+    if run.returncode:
+        print("*** %s failed with status %d" % (name, run.returncode))
+        status = 1
+sys.exit(status)
@@ -0,0 +1,51 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Driver/delay_usecs.h"
+#include "sim.h"
+
+#include <chrono>
+#include <thread>
+
+float sim_speed = 1.0f;
+
+using wall_clock = std::chrono::steady_clock;
+
+static const wall_clock::time_point wall_start = wall_clock::now();
+
+uint64_t sim_nanos() {
+    std::chrono::duration<double, std::nano> elapsed = wall_clock::now() - wall_start;
+    return uint64_t(elapsed.count() * sim_speed);
+}
+
+void sim_sleep_nanos(uint64_t nanos) {
+    std::this_thread::sleep_for(std::chrono::duration<double, std::nano>(nanos / sim_speed));
+}
+
+// The cycle counter runs at the clock rate of a typical ESP32 so code that
+// scales by ticks_per_us behaves the same way, including 32-bit wraparound.
+uint32_t ticks_per_us;
+
+void timing_init() {
+    ticks_per_us = 240;
+}
+
+void delay_us(int32_t us) {
+    spinUntil(usToEndTicks(us));
+}
+
+int32_t usToCpuTicks(int32_t us) {
+    return us * ticks_per_us;
+}
+
+int32_t usToEndTicks(int32_t us) {
+    return getCpuTicks() + usToCpuTicks(us);
+}
+
+void spinUntil(int32_t endTicks) {
+    while ((getCpuTicks() - endTicks) < 0) {}
+}
+
+int32_t getCpuTicks() {
+    return int32_t(sim_nanos() * ticks_per_us / 1000);
+}
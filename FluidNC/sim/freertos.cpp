@@ -0,0 +1,244 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// The subset of FreeRTOS and Arduino timing services that FluidNC uses,
+// implemented with host threads and the simulator's virtual clock.
+// Tasks are std::threads; there is no priority scheduling, and
+// vTaskSuspend() takes effect the next time the task delays.
+
+#include "sim.h"
+
+#include <freertos/FreeRTOS.h>
+#include <Arduino.h>
+#include <esp32-hal.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+struct SimTask {
+    std::atomic<bool> suspended { false };
+
+    // Task notification
+    std::mutex              notify_mutex;
+    std::condition_variable notify_cv;
+    uint32_t                notify_count = 0;
+};
+
+static thread_local SimTask* current_task = nullptr;
+
+struct TaskStart {
+    TaskFunction_t code;
+    void*          parameters;
+    SimTask*       task;
+};
+
+static void task_trampoline(TaskStart start) {
+    current_task = start.task;
+    start.code(start.parameters);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t      pvTaskCode,
+                                   const char* const   pcName,
+                                   const uint32_t      usStackDepth,
+                                   void* const         pvParameters,
+                                   UBaseType_t         uxPriority,
+                                   TaskHandle_t* const pvCreatedTask,
+                                   const BaseType_t    xCoreID) {
+    auto task = new SimTask;
+    std::thread(task_trampoline, TaskStart { pvTaskCode, pvParameters, task }).detach();
+    if (pvCreatedTask) {
+        *pvCreatedTask = task;
+    }
+    return pdTRUE;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return current_task;
+}
+
+void vTaskSuspend(TaskHandle_t xTaskToSuspend) {
+    auto task = static_cast<SimTask*>(xTaskToSuspend ? xTaskToSuspend : current_task);
+    if (task) {
+        task->suspended = true;
+    }
+}
+
+void vTaskResume(TaskHandle_t xTaskToResume) {
+    auto task = static_cast<SimTask*>(xTaskToResume);
+    if (task) {
+        task->suspended = false;
+    }
+}
+
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority) {}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+    if (xTicksToDelay) {
+        sim_sleep_nanos(uint64_t(xTicksToDelay) * portTICK_PERIOD_MS * 1000000);
+    } else {
+        std::this_thread::yield();
+    }
+    while (current_task && current_task->suspended) {
+        sim_sleep_nanos(1000000);
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    auto task = current_task;
+    if (!task) {
+        return 0;
+    }
+    std::unique_lock<std::mutex> lock(task->notify_mutex);
+    auto                         notified = [task] { return task->notify_count != 0; };
+    if (xTicksToWait == portMAX_DELAY) {
+        task->notify_cv.wait(lock, notified);
+    } else {
+        // Virtual time runs sim_speed times faster than the host clock
+        auto nanos = uint64_t(double(xTicksToWait) * portTICK_PERIOD_MS * 1000000 / sim_speed);
+        task->notify_cv.wait_for(lock, std::chrono::nanoseconds(nanos), notified);
+    }
+    uint32_t count = task->notify_count;
+    if (count) {
+        task->notify_count = xClearCountOnExit ? 0 : count - 1;
+    }
+    return count;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken) {
+    auto task = static_cast<SimTask*>(xTaskToNotify);
+    {
+        std::lock_guard<std::mutex> lock(task->notify_mutex);
+        ++task->notify_count;
+    }
+    task->notify_cv.notify_one();
+    if (pxHigherPriorityTaskWoken) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+}
+
+TickType_t xTaskGetTickCount() {
+    return TickType_t(sim_nanos() / (1000000 * portTICK_PERIOD_MS));
+}
+
+void vTaskDelayUntil(TickType_t* const pxPreviousWakeTime, const TickType_t xTimeIncrement) {
+    *pxPreviousWakeTime += xTimeIncrement;
+    int32_t remaining = int32_t(*pxPreviousWakeTime - xTaskGetTickCount());
+    vTaskDelay(remaining > 0 ? remaining : 0);
+}
+
+// Queues.  The queue structure comes from the X86 test support headers.
+// Blocking receives poll, which is adequate for the message and event
+// queues that carry at most a few hundred items per second.
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType) {
+    auto queue         = new QueueHandle();
+    queue->entrySize   = uxItemSize;
+    queue->numberItems = uxQueueLength + 1;  // One slot is always empty
+    queue->data.resize(uxItemSize * queue->numberItems);
+    return queue;
+}
+
+static bool queue_receive(QueueHandle_t xQueue, void* const pvBuffer) {
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+
+    if (xQueue->readIndex == xQueue->writeIndex) {
+        return false;
+    }
+    memcpy(pvBuffer, xQueue->data.data() + xQueue->readIndex, xQueue->entrySize);
+    xQueue->readIndex += xQueue->entrySize;
+    if (xQueue->readIndex == xQueue->data.size()) {
+        xQueue->readIndex = 0;
+    }
+    return true;
+}
+
+BaseType_t xQueueGenericReceive(QueueHandle_t xQueue, void* const pvBuffer, TickType_t xTicksToWait, const BaseType_t xJustPeek) {
+    TickType_t start = xTaskGetTickCount();
+    while (!queue_receive(xQueue, pvBuffer)) {
+        if (xTicksToWait != portMAX_DELAY && (xTaskGetTickCount() - start) >= xTicksToWait) {
+            return pdFALSE;
+        }
+        vTaskDelay(1);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t     xQueue,
+                                    const void* const pvItemToQueue,
+                                    BaseType_t* const pxHigherPriorityTaskWoken,
+                                    const BaseType_t  xCopyPosition) {
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+
+    auto next = xQueue->writeIndex + xQueue->entrySize;
+    if (next == xQueue->data.size()) {
+        next = 0;
+    }
+    if (next == xQueue->readIndex) {
+        return errQUEUE_FULL;
+    }
+    memcpy(xQueue->data.data() + xQueue->writeIndex, pvItemToQueue, xQueue->entrySize);
+    xQueue->writeIndex = next;
+    return pdTRUE;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void* const pvItemToQueue, TickType_t xTicksToWait, BaseType_t xCopyPosition) {
+    TickType_t start = xTaskGetTickCount();
+    while (xQueueGenericSendFromISR(xQueue, pvItemToQueue, nullptr, xCopyPosition) != pdTRUE) {
+        if (xTicksToWait != portMAX_DELAY && (xTaskGetTickCount() - start) >= xTicksToWait) {
+            return errQUEUE_FULL;
+        }
+        vTaskDelay(1);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+
+    xQueue->writeIndex = xQueue->readIndex = 0;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+
+    auto used = xQueue->writeIndex + xQueue->data.size() - xQueue->readIndex;
+    return (used % xQueue->data.size()) / xQueue->entrySize;
+}
+
+// Arduino timing
+
+unsigned long micros() {
+    return (unsigned long)(sim_nanos() / 1000);
+}
+
+unsigned long millis() {
+    return (unsigned long)(sim_nanos() / 1000000);
+}
+
+int64_t esp_timer_get_time() {
+    return int64_t(sim_nanos() / 1000);
+}
+
+void delay(uint32_t ms) {
+    vTaskDelay(ms / portTICK_PERIOD_MS);
+}
+
+void delay(int ms) {
+    vTaskDelay(ms / portTICK_PERIOD_MS);
+}
+
+void delayMicroseconds(uint32_t us) {
+    sim_sleep_nanos(uint64_t(us) * 1000);
+}
+
+uint32_t getApbFrequency() {
+    return 80000000;
+}
+
+const char* esp_get_idf_version() {
+    return "host simulator";
+}
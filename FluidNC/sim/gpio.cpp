@@ -0,0 +1,91 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Simulated GPIOs.  Outputs are latched so that reading an output returns
+// what was written.  Inputs read as the level implied by their pull
+// resistors.  Input events are delivered by poll_gpios() the same way
+// as on the ESP32, so limit switches and control pins work normally if
+// something changes their level.
+
+#include "src/Protocol.h"
+#include "Driver/fluidnc_gpio.h"
+
+#include <atomic>
+
+const int GPIO_NUM_MAX = 64;
+
+typedef uint64_t gpio_mask_t;
+
+static std::atomic<gpio_mask_t> gpio_levels { 0 };
+
+static gpio_mask_t gpio_mask(int gpio_num) {
+    return 1ULL << gpio_num;
+}
+
+void gpio_write(pinnum_t pin, int value) {
+    if (value) {
+        gpio_levels |= gpio_mask(pin);
+    } else {
+        gpio_levels &= ~gpio_mask(pin);
+    }
+}
+
+int gpio_read(pinnum_t pin) {
+    return (gpio_levels & gpio_mask(pin)) != 0;
+}
+
+void gpio_mode(pinnum_t pin, int input, int output, int pullup, int pulldown, int opendrain) {
+    if (input && !output) {
+        gpio_write(pin, pullup);
+    }
+}
+
+void gpio_drive_strength(pinnum_t pin, int strength) {}
+
+void gpio_route(pinnum_t pin, uint32_t signal) {}
+
+static gpio_mask_t gpios_inverted = 0;  // GPIOs that are active low
+static gpio_mask_t gpios_interest = 0;  // GPIOs with an action
+static gpio_mask_t gpios_current  = 0;  // The last GPIO action events that were sent
+
+static void* gpioArgs[GPIO_NUM_MAX + 1];
+
+static gpio_mask_t get_gpios() {
+    return gpio_levels ^ gpios_inverted;
+}
+
+static void gpios_update(gpio_mask_t& gpios, int gpio_num, bool active) {
+    if (active) {
+        gpios |= gpio_mask(gpio_num);
+    } else {
+        gpios &= ~gpio_mask(gpio_num);
+    }
+}
+
+void gpio_set_event(int gpio_num, void* arg, int invert) {
+    gpioArgs[gpio_num] = arg;
+    gpios_update(gpios_interest, gpio_num, true);
+    gpios_update(gpios_inverted, gpio_num, invert);
+    // Set current to the opposite of the current state so the first poll will send the current state
+    gpios_update(gpios_current, gpio_num, !(get_gpios() & gpio_mask(gpio_num)));
+}
+
+void gpio_clear_event(int gpio_num) {
+    gpioArgs[gpio_num] = nullptr;
+    gpios_update(gpios_interest, gpio_num, false);
+}
+
+void poll_gpios() {
+    gpio_mask_t gpios_active  = get_gpios();
+    gpio_mask_t gpios_changed = (gpios_active ^ gpios_current) & gpios_interest;
+    while (gpios_changed) {
+        int  gpio_num = 63 - __builtin_clzll(gpios_changed);
+        bool active   = gpios_active & gpio_mask(gpio_num);
+        auto arg      = gpioArgs[gpio_num];
+        if (arg) {
+            protocol_send_event_from_ISR(active ? &pinActiveEvent : &pinInactiveEvent, arg);
+        }
+        gpios_update(gpios_current, gpio_num, active);
+        gpios_update(gpios_changed, gpio_num, false);
+    }
+}
@@ -0,0 +1,13 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include <Driver/gpio_dump.h>
+#include <Driver/fluidnc_gpio.h>
+
+void gpio_dump(Print& out) {
+    for (pinnum_t gpio = 0; gpio < 40; gpio++) {
+        out.print("gpio.");
+        out.print(int(gpio));
+        out.print(gpio_read(gpio) ? " 1\n" : " 0\n");
+    }
+}
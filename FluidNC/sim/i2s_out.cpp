@@ -0,0 +1,36 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// I2S output expander for the host simulator.  The shift register
+// contents are kept in a word; writes take effect immediately.
+
+#include "Driver/i2s_out.h"
+
+#include <atomic>
+
+static std::atomic<uint32_t> i2s_out_port_data { 0 };
+static bool                  i2s_out_initialized = false;
+
+int i2s_out_init(i2s_out_init_t* init_param) {
+    if (i2s_out_initialized) {
+        return -1;
+    }
+    i2s_out_port_data   = init_param->init_val;
+    i2s_out_initialized = true;
+    return 0;
+}
+
+uint8_t i2s_out_read(pinnum_t pin) {
+    return !!(i2s_out_port_data & (1 << pin));
+}
+
+void i2s_out_write(pinnum_t pin, uint8_t val) {
+    uint32_t bit = 1 << pin;
+    if (val) {
+        i2s_out_port_data |= bit;
+    } else {
+        i2s_out_port_data &= ~bit;
+    }
+}
+
+void i2s_out_delay() {}
@@ -0,0 +1,113 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// File systems for the host simulator.  Each FluidNC mount point is a
+// subdirectory of the simulator's working directory, so /littlefs/config.yaml
+// is ./littlefs/config.yaml and /sd/job.nc is ./sd/job.nc
+
+#include "Driver/localfs.h"
+#include "src/Config.h"
+
+#include <cstring>
+#include <strings.h>
+
+const char* localfsName = NULL;
+
+bool localfs_mount() {
+    std::error_code ec;
+    std::filesystem::create_directory(littlefsName, ec);
+    if (ec) {
+        log_error("Cannot create the local filesystem directory " << littlefsName);
+        return true;
+    }
+    localfsName = littlefsName;
+    return false;
+}
+
+void localfs_unmount() {
+    localfsName = NULL;
+}
+
+bool localfs_format(const char* fsname) {
+    if (!strcasecmp(fsname, "format") || !strcasecmp(fsname, "localfs")) {
+        fsname = defaultLocalfsName;
+    }
+    if (strcasecmp(fsname, littlefsName)) {
+        localfsName = "";
+        return true;
+    }
+    std::error_code ec;
+    for (auto const& entry : std::filesystem::directory_iterator(littlefsName, ec)) {
+        std::filesystem::remove_all(entry.path(), ec);
+    }
+    return localfs_mount();
+}
+
+uint64_t localfs_size() {
+    std::error_code ec;
+
+    auto space = std::filesystem::space(localfsName, ec);
+    if (ec) {
+        return 0;
+    }
+    return space.capacity;
+}
+
+static void insertFsName(char* s, const char* prefix) {
+    size_t slen = strlen(s);
+    size_t plen = strlen(prefix);
+    memmove(s + 1 + plen, s, slen + 1);
+    memmove(s + 1, prefix, plen);
+    *s = '/';
+}
+
+static bool replacedFsName(char* s, const char* replaced, const char* with) {
+    if (*s != '/') {
+        return false;
+    }
+
+    char*       head = s + 1;
+    const char* tail = strchrnul(head, '/');  // tail string after prefix
+    size_t      plen = tail - head;           // Prefix length
+    size_t      rlen = strlen(replaced);      // replaced length
+
+    if (plen != rlen) {
+        return false;
+    }
+
+    if (strncasecmp(head, replaced, rlen) == 0) {
+        size_t tlen = strlen(tail);
+        size_t wlen = strlen(with);
+
+        if (wlen != rlen) {
+            memmove(head + wlen, tail, tlen + 1);
+        }
+        memmove(head, with, wlen);
+        return true;
+    }
+    return false;
+}
+
+// The mapping of file system names is the same as on the ESP32, except
+// that the result is relative to the working directory.  FluidPath still
+// finds the mount point as the second path component.  A path that is
+// already canonical, such as one from FluidPath, is returned unchanged.
+const char* canonicalPath(const char* filename, const char* defaultFs) {
+    static char path[130];
+    if (filename[0] == '.' && filename[1] == '/') {
+        strncpy(path, filename, sizeof(path) - 1);
+        return path;
+    }
+    path[0] = '.';
+    char* fsPath = path + 1;
+    strncpy(fsPath, filename, 128);
+
+    if (!(replacedFsName(fsPath, "localfs", localfsName) || replacedFsName(fsPath, spiffsName, localfsName) ||
+          replacedFsName(fsPath, littlefsName, localfsName) || replacedFsName(fsPath, sdName, sdName))) {
+        if (*filename != '/') {
+            insertFsName(fsPath, "");
+        }
+        insertFsName(fsPath, strcmp(defaultFs, "") ? defaultFs : localfsName);
+    }
+    return path;
+}
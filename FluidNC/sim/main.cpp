@@ -0,0 +1,116 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+/*
+  Entry point for the host simulator
+
+    fluidnc_sim [-b] [-d directory] [-s speed] [-t trace.csv] < job.nc
+
+  The directory (default .) holds the simulated file systems: littlefs/
+  is the local file system, where config.yaml is found, and sd/ is the SD
+  card.  The console is stdin/stdout.  When stdin reaches end of file, the
+  simulator waits for motion to finish, prints a summary of the step
+  activity on stderr and exits, with status 1 if the machine is in alarm.
+  With -b, the summary also has the time spent in each stage of the
+  motion pipeline; bench.py runs the standard benchmark streams that way.
+*/
+
+#include "src/Job.h"
+#include "src/Planner.h"
+#include "src/State.h"
+#include "src/UartChannel.h"
+#include "sim.h"
+
+#include <freertos/FreeRTOS.h>
+
+#include <cstdlib>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+extern Channel* activeChannel;  // Protocol.cpp
+
+static bool benchmark = false;
+
+// Every input line has been executed when the console has been read to
+// the end, the channel has no characters queued, and the protocol loop
+// does not have a line in progress.  Channel::available() is the count
+// of queued characters; UartChannel overrides it to look at the UART.
+static bool input_done() {
+    return sim_console_drained() && Uart0.Channel::available() == 0 && activeChannel == nullptr;
+}
+
+static bool machine_is_quiet() {
+    return !Job::active() && plan_get_current_block() == nullptr &&
+           (state_is(State::Idle) || state_is(State::CheckMode) || state_is(State::Alarm) || state_is(State::ConfigAlarm) ||
+            state_is(State::Critical));
+}
+
+// A line passes from the console to the protocol loop through the polling
+// task, so require everything to stay quiet for half a second before exiting.
+static void exit_when_done(void* unused) {
+    int quiet_polls = 0;
+    while (true) {
+        vTaskDelay(50);
+        if (!(input_done() && machine_is_quiet())) {
+            quiet_polls = 0;
+            continue;
+        }
+        if (++quiet_polls == 10) {
+            sim_engine_report(stderr);
+            if (benchmark) {
+                sim_bench_report(stderr);
+            }
+            sim_trace_close();
+            fflush(stdout);
+            fflush(stderr);
+            // The other tasks are still running, so skip the static destructors
+            _exit(state_is(State::Idle) || state_is(State::CheckMode) ? 0 : 1);
+        }
+    }
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-b] [-d directory] [-s speed] [-t trace.csv] < job.nc\n", name);
+    exit(2);
+}
+
+int main(int argc, char* argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "bd:s:t:")) != -1) {
+        switch (opt) {
+            case 'b':
+                benchmark = true;
+                break;
+            case 'd':
+                if (chdir(optarg)) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            case 's':
+                sim_speed = strtof(optarg, nullptr);
+                if (sim_speed <= 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 't':
+                if (!sim_trace_open(optarg)) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    xTaskCreate(exit_when_done, "simexit", 4096, nullptr, 1, nullptr);
+
+    setup();
+    while (true) {
+        loop();
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Driver/restart.h"
+#include "sim.h"
+
+#include <cstdlib>
+
+void restart() {
+    sim_trace_close();
+    exit(0);
+}
+
+bool restart_was_panic() {
+    return false;
+}
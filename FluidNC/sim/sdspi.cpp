@@ -0,0 +1,25 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// The simulated SD card is the sd/ subdirectory of the simulator's
+// working directory.  canonicalPath() maps /sd/... there.
+
+#include "Driver/sdspi.h"
+
+#include <filesystem>
+
+bool sd_init_slot(uint32_t freq_hz, int cs_pin, int cd_pin, int wp_pin) {
+    return true;
+}
+
+std::error_code sd_mount(int max_files) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory("sd", ec)) {
+        return std::make_error_code(std::errc::no_such_device);
+    }
+    return {};
+}
+
+void sd_unmount() {}
+
+void sd_deinit_slot() {}
@@ -0,0 +1,43 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Interfaces that are private to the host simulator.  The rest of the
+// firmware talks to the simulated hardware through include/Driver/*.h
+
+#include <cstdint>
+#include <cstdio>
+
+// Elapsed virtual time since startup.  Every clock in the simulator - FreeRTOS
+// ticks, millis(), CPU cycle counts and the step timer - is derived from this,
+// so they all stay consistent when sim_speed is not 1.0.
+uint64_t sim_nanos();
+void     sim_sleep_nanos(uint64_t nanos);
+
+// The step timer keeps its own virtual time in ticks of Stepping::fStepperTimer.
+// It advances by the programmed period each time the step "ISR" runs, and
+// it catches up with sim_nanos() whenever the timer is started.
+uint64_t sim_isr_ticks();
+uint32_t sim_timer_frequency();
+
+// The ratio of virtual time to wall-clock time.  1.0 runs in real time,
+// larger numbers run faster.  The step ISR is paced so it never gets ahead
+// of sim_nanos(), so the planner and segment prep see the same deadlines
+// that they would see on hardware when sim_speed is 1.0.
+extern float sim_speed;
+
+// Step/dir edge recording by the virtual step engine
+bool sim_trace_open(const char* filename);
+void sim_trace_close();
+void sim_engine_report(FILE* out);
+
+// Step pulses that have been sent on a pin since startup
+uint64_t sim_step_count(int pin);
+
+// Per-stage timing of the planner and segment prep; see Driver/benchmark.h
+void sim_bench_report(FILE* out);
+
+// True once the console input stream has reached end of file and every
+// character has been consumed.
+bool sim_console_drained();
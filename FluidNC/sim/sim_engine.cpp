@@ -0,0 +1,207 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Virtual stepping engine for the host simulator.  Instead of driving
+// pins, it records every step and direction edge with its virtual time,
+// in ticks of the step timer.  Within one ISR, edges are placed where the
+// hardware would put them: direction changes first, then the step pulses
+// after dir_delay_us, then the trailing edges after pulse_us.
+//
+// The engine is registered under the names of all of the ESP32 engines,
+// so a machine config selects it unchanged whatever its stepping/engine is.
+//
+// The trace is CSV with one edge per line:  ticks,kind,pin,level
+// where kind is S for a step pin and D for a direction pin.
+
+#include "Driver/step_engine.h"
+#include "Driver/StepTimer.h"
+#include "sim.h"
+
+#include <cinttypes>
+
+static const int MAX_PINS = 256;
+
+static uint32_t _dir_delay_us;
+static uint32_t _pulse_delay_us;
+static uint32_t _dir_delay_ticks;
+static uint32_t _pulse_ticks;
+
+static uint64_t _isr_ticks;  // Virtual time of the ISR whose edges are being placed
+static uint64_t _edge_ticks;  // Time of the next edge within that ISR
+static uint64_t _unstep_ticks;
+static bool     _unstepping;
+
+static uint8_t  _levels[MAX_PINS];
+static uint64_t _step_count[MAX_PINS];
+static uint64_t _dir_count[MAX_PINS];
+static uint64_t _isr_count;
+
+static FILE* _trace;
+
+bool sim_trace_open(const char* filename) {
+    _trace = fopen(filename, "w");
+    if (!_trace) {
+        return false;
+    }
+    setvbuf(_trace, NULL, _IOFBF, 1 << 20);
+    fprintf(_trace, "ticks,kind,pin,level\n");
+    return true;
+}
+
+void sim_trace_close() {
+    if (_trace) {
+        fclose(_trace);
+        _trace = NULL;
+    }
+}
+
+void sim_engine_report(FILE* out) {
+    fprintf(out, "Step ISRs: %" PRIu64 "  Virtual time: %.6f s\n", _isr_count, double(sim_isr_ticks()) / sim_timer_frequency());
+    for (int pin = 0; pin < MAX_PINS; pin++) {
+        if (_step_count[pin]) {
+            fprintf(out, "Step pin %d: %" PRIu64 " steps\n", pin, _step_count[pin]);
+        }
+        if (_dir_count[pin]) {
+            fprintf(out, "Dir pin %d: %" PRIu64 " changes\n", pin, _dir_count[pin]);
+        }
+    }
+}
+
+uint64_t sim_step_count(int pin) {
+    return pin >= 0 && pin < MAX_PINS ? _step_count[pin] : 0;
+}
+
+static void record(uint64_t ticks, char kind, int pin, int level) {
+    if (_trace) {
+        fprintf(_trace, "%" PRIu64 ",%c,%d,%d\n", ticks, kind, pin, level);
+    }
+}
+
+// Start placing edges for a new ISR if the timer has advanced
+static void sync_isr() {
+    uint64_t now = sim_isr_ticks();
+    if (now != _isr_ticks) {
+        _isr_ticks  = now;
+        _edge_ticks = now;
+        ++_isr_count;
+    }
+}
+
+static uint32_t us_to_ticks(uint32_t us) {
+    return uint32_t(uint64_t(us) * sim_timer_frequency() / 1000000);
+}
+
+static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_delay_us, uint32_t frequency, bool (*callback)(void)) {
+    stepTimerInit(frequency, callback);
+    _dir_delay_us    = dir_delay_us;
+    _pulse_delay_us  = pulse_delay_us;
+    _dir_delay_ticks = us_to_ticks(dir_delay_us);
+    _pulse_ticks     = us_to_ticks(pulse_delay_us);
+    return _pulse_delay_us;
+}
+
+static int init_step_pin(int step_pin, int step_invert) {
+    _levels[step_pin & (MAX_PINS - 1)] = step_invert;
+    return step_pin;
+}
+
+static void set_dir_pin(int pin, int level) {
+    pin &= MAX_PINS - 1;
+    if (_levels[pin] != level) {
+        sync_isr();
+        _levels[pin] = level;
+        ++_dir_count[pin];
+        record(_edge_ticks, 'D', pin, level);
+    }
+}
+
+static void finish_dir() {
+    _edge_ticks += _dir_delay_ticks;
+}
+
+static void start_step() {
+    sync_isr();
+}
+
+static void set_step_pin(int pin, int level) {
+    pin &= MAX_PINS - 1;
+    if (_levels[pin] != level) {
+        _levels[pin] = level;
+        if (_unstepping) {
+            record(_unstep_ticks, 'S', pin, level);
+        } else {
+            ++_step_count[pin];
+            record(_edge_ticks, 'S', pin, level);
+        }
+    }
+}
+
+static void write_step_pins(uint32_t pins, uint32_t levels) {
+    for (int pin = 0; pins; pin++, pins >>= 1, levels >>= 1) {
+        if (pins & 1) {
+            set_step_pin(pin, levels & 1);
+        }
+    }
+}
+
+static void finish_step() {
+    _unstep_ticks = _edge_ticks + _pulse_ticks;
+}
+
+static int start_unstep() {
+    _unstepping = true;
+    return 0;
+}
+
+static void finish_unstep() {
+    _unstepping = false;
+}
+
+static uint32_t max_pulses_per_sec() {
+    return 1000000 / (2 * (_pulse_delay_us ? _pulse_delay_us : 1));
+}
+
+// The RMT engine inserts the direction delay ahead of every pulse
+static uint32_t rmt_max_pulses_per_sec() {
+    return 1000000 / (2 * (_pulse_delay_us ? _pulse_delay_us : 1) + _dir_delay_us);
+}
+
+static void set_timer_ticks(uint32_t ticks) {
+    stepTimerSetTicks(ticks);
+}
+
+static void start_timer() {
+    stepTimerStart();
+}
+
+static void stop_timer() {
+    stepTimerStop();
+}
+
+// clang-format off
+#define SIM_ENGINE(ename, max_pps) \
+    {                              \
+        ename,                     \
+        init_engine,               \
+        init_step_pin,             \
+        set_dir_pin,               \
+        finish_dir,                \
+        start_step,                \
+        set_step_pin,              \
+        finish_step,               \
+        start_unstep,              \
+        finish_unstep,             \
+        max_pps,                   \
+        set_timer_ticks,           \
+        start_timer,               \
+        stop_timer,                \
+        write_step_pins            \
+    }
+
+static step_engine_t timed_engine = SIM_ENGINE("Timed", max_pulses_per_sec);
+static step_engine_t rmt_engine   = SIM_ENGINE("RMT", rmt_max_pulses_per_sec);
+static step_engine_t i2s_engine   = SIM_ENGINE("I2S", max_pulses_per_sec);
+
+REGISTER_STEP_ENGINE(Timed, &timed_engine);
+REGISTER_STEP_ENGINE(RMT, &rmt_engine);
+REGISTER_STEP_ENGINE(I2S, &i2s_engine);
@@ -0,0 +1,13 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// There are no SPI devices on the host, but the bus must come up so an
+// sdcard: section in the config can map the SD card to a directory.
+
+#include "Driver/spi.h"
+
+bool spi_init_bus(pinnum_t sck_pin, pinnum_t miso_pin, pinnum_t mosi_pin, bool dma, int8_t sck_drive_strength, int8_t mosi_drive_strength) {
+    return true;
+}
+
+void spi_deinit_bus() {}
@@ -0,0 +1,116 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// UARTs for the host simulator.  UART0, the console, is connected to
+// stdin and stdout so the simulator can be driven interactively or fed a
+// G-code file with input redirection.  Input is staged through a buffer
+// the size of the ESP32 driver's receive buffer; the reader thread blocks
+// when it is full, so piped input is never dropped.  Reading stdin starts
+// with the first read from the console, so the input flush that is done by
+// the startup reset does not throw away the beginning of a piped job.  The
+// other UARTs are not connected to anything.
+
+#include <Driver/fluidnc_uart.h>
+#include "sim.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+static const size_t rx_buffer_size = 256;
+
+static std::deque<uint8_t>     rx_buffer;
+static std::mutex              rx_mutex;
+static std::condition_variable rx_space;
+static bool                    rx_eof = false;
+
+static void stdin_reader() {
+    uint8_t buf[64];
+    ssize_t len;
+    while ((len = read(STDIN_FILENO, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < len; i++) {
+            std::unique_lock<std::mutex> lock(rx_mutex);
+            rx_space.wait(lock, [] { return rx_buffer.size() < rx_buffer_size; });
+            rx_buffer.push_back(buf[i]);
+        }
+    }
+    std::lock_guard<std::mutex> lock(rx_mutex);
+    rx_eof = true;
+}
+
+bool sim_console_drained() {
+    std::lock_guard<std::mutex> lock(rx_mutex);
+    return rx_eof && rx_buffer.empty();
+}
+
+void uart_init(int uart_num) {}
+
+void uart_mode(int uart_num, unsigned long baud, UartData dataBits, UartParity parity, UartStop stopBits) {}
+
+bool uart_half_duplex(int uart_num) {
+    return false;
+}
+
+int uart_read(int uart_num, uint8_t* buf, int len, int timeout_ms) {
+    if (uart_num) {
+        return 0;
+    }
+    static bool console_started = false;
+    if (!console_started) {
+        console_started = true;
+        std::thread(stdin_reader).detach();
+    }
+    int count = 0;
+    {
+        std::lock_guard<std::mutex> lock(rx_mutex);
+        while (count < len && !rx_buffer.empty()) {
+            buf[count++] = rx_buffer.front();
+            rx_buffer.pop_front();
+        }
+    }
+    if (count) {
+        rx_space.notify_one();
+    }
+    return count;
+}
+
+int uart_write(int uart_num, const uint8_t* buf, int len) {
+    if (uart_num) {
+        return len;
+    }
+    return int(write(STDOUT_FILENO, buf, len));
+}
+
+void uart_xon(int uart_num) {}
+
+void uart_xoff(int uart_num) {}
+
+void uart_sw_flow_control(int uart_num, bool on, int xon_threshold, int xoff_threshold) {}
+
+bool uart_pins(int uart_num, int tx_pin, int rx_pin, int rts_pin, int cts_pin) {
+    return false;
+}
+
+int uart_buflen(int uart_num) {
+    if (uart_num) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(rx_mutex);
+    return int(rx_buffer.size());
+}
+
+void uart_discard_input(int uart_num) {
+    if (uart_num == 0) {
+        std::lock_guard<std::mutex> lock(rx_mutex);
+        rx_buffer.clear();
+    }
+    rx_space.notify_one();
+}
+
+bool uart_wait_output(int uart_num, int timeout_ms) {
+    return false;
+}
+
+void uart_register_input_pin(int uart_num, uint8_t pinnum, InputPin* object) {}
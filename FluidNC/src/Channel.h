@@ -201,6 +201,10 @@ public:
     virtual size_t position() { return 0; }
     virtual void   set_position(size_t pos) {}
 
+    // The words of the line that pollLine() last returned, if the channel had them
+    // ahead of time, as with a job file that has been compiled by GCodeCache
+    virtual const gc_words_t* compiledLine() { return nullptr; }
+
     void pause();
     void resume();
 };
@@ -45,6 +45,7 @@ const int B2_AXIS = (B_AXIS + MAX_N_AXIS);
 const int C2_AXIS = (C_AXIS + MAX_N_AXIS);
 
 const int SUPPORT_TASK_CORE = 0;  // Reference: CONFIG_ARDUINO_RUNNING_CORE = 1
+const int PREP_TASK_CORE    = 1;  // Segment prep, opposite the support tasks
 
 // Serial baud rate
 // OK to change, but the ESP32 boot text is 115200, so you will not see that is your
@@ -138,8 +139,18 @@ const int REPORT_WCO_REFRESH_IDLE_COUNT = 10;  // (2-255) Must be less than or e
 // NOTE: Changing this value also changes the execution time of a segment in the step segment buffer.
 // When increasing this value, this stores less overall time in the segment buffer and vice versa. Make
 // certain the step segment buffer is increased/decreased to account for these changes.
+// This is the default for the stepping: acceleration_ticks_per_sec config item.  The companion
+// item cruise_ticks_per_sec can set a lower rate - longer segments - for constant-speed motion.
 const int ACCELERATION_TICKS_PER_SECOND = 100;
 
+// Generates step segments with 64-bit integer arithmetic instead of float. The velocity profile of
+// each block is still computed in float, but the per-segment ramp, step count and step rate
+// calculations are integer only, which is much cheaper on processors without a floating point unit.
+// Step totals are identical to the float generator. On the ESP32 and the Cortex-M4F STM32 parts,
+// which have single precision FPUs, the float generator is usually as fast. The fixed-point generator
+// has only constant-acceleration ramps, so it ignores the jerk_mm_per_sec3 axis settings.
+// #define PREP_FIXED_POINT  // Uncomment to enable, or add -DPREP_FIXED_POINT to build_flags
+
 // Sets which axis the tool length offset is applied. Assumes the spindle is always parallel with
 // the selected axis with the tool oriented toward the negative direction. In other words, a positive
 // tool length offset value is subtracted from the current location.
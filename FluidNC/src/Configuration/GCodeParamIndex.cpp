@@ -0,0 +1,101 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "GCodeParamIndex.h"
+
+#include "../NutsBolts.h"  // constrain_with_message()
+
+namespace Configuration {
+    // The conversions match those in GCodeParam
+    bool GCodeParamItem::get(float& value) const {
+        switch (_type) {
+            case Bool:
+                value = *static_cast<bool*>(_value);
+                break;
+            case Int32:
+                value = *static_cast<int32_t*>(_value);
+                break;
+            case UInt8:
+                value = *static_cast<uint8_t*>(_value);
+                break;
+            case UInt32:
+                value = *static_cast<uint32_t*>(_value);
+                break;
+            case Float:
+                value = *static_cast<float*>(_value);
+                break;
+            case Enum:
+                value = *static_cast<int*>(_value);
+                break;
+        }
+        return true;
+    }
+
+    bool GCodeParamItem::set(float value) const {
+        switch (_type) {
+            case Bool:
+                *static_cast<bool*>(_value) = value;
+                break;
+            case Int32:
+                *static_cast<int32_t*>(_value) = value;
+                break;
+            case UInt8:
+                *static_cast<uint8_t*>(_value) = int32_t(value);
+                break;
+            case UInt32: {
+                if (value < 0) {
+                    return false;
+                }
+                uint32_t& item = *static_cast<uint32_t*>(_value);
+                item           = value;
+                constrain_with_message(item, uint32_t(_minValue), uint32_t(_maxValue));
+            } break;
+            case Float: {
+                float& item = *static_cast<float*>(_value);
+                item        = value;
+                constrain_with_message(item, float(_minValue), float(_maxValue));
+            } break;
+            case Enum:
+                *static_cast<int*>(_value) = value;
+                break;
+        }
+        return true;
+    }
+
+    GCodeParamIndex::index_t GCodeParamIndex::_index;
+    std::deque<std::string>  GCodeParamIndex::_paths;
+
+    void GCodeParamIndex::add(const char* name, GCodeParamItem::Type type, void* value, double minValue, double maxValue) {
+        _paths.emplace_back(_path + name);
+        // As with GCodeParam, the first item with a given path wins
+        _index.emplace(_paths.back(), GCodeParamItem(type, value, minValue, maxValue));
+    }
+
+    void GCodeParamIndex::enterSection(const char* name, Configuration::Configurable* value) {
+        auto previous = _path.length();
+        _path += name;
+        _path += '/';
+        value->group(*this);
+        _path.resize(previous);
+    }
+
+    void GCodeParamIndex::build(Configurable* root) {
+        _index.clear();
+        _paths.clear();
+
+        GCodeParamIndex indexer;
+        root->group(indexer);
+    }
+
+    const GCodeParamItem* GCodeParamIndex::find(std::string_view path) {
+        // Remove leading and trailing '/' as GCodeParam does
+        if (!path.empty() && path.front() == '/') {
+            path.remove_prefix(1);
+        }
+        if (!path.empty() && path.back() == '/') {
+            path.remove_suffix(1);
+        }
+        auto it = _index.find(path);
+        return it == _index.end() ? nullptr : &it->second;
+    }
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "HandlerBase.h"
+#include "Configurable.h"
+#include "src/string_util.h"
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Configuration {
+    // A numeric config item that a #</path> parameter can read and write directly
+    class GCodeParamItem {
+    public:
+        enum Type : uint8_t { Bool, Int32, UInt8, UInt32, Float, Enum };
+
+        GCodeParamItem(Type type, void* value, double minValue, double maxValue) :
+            _type(type), _value(value), _minValue(minValue), _maxValue(maxValue) {}
+
+        bool get(float& value) const;
+        bool set(float value) const;
+
+    private:
+        Type   _type;
+        void*  _value;
+        double _minValue;  // Exact for both uint32_t and float limits
+        double _maxValue;
+    };
+
+    // Indexes the numeric items of the config tree by path after the config is
+    // loaded, so that #</axes/x/steps_per_mm> is found with one hash lookup
+    // instead of a walk through the tree with GCodeParam.  Items that are not
+    // in the index, such as strings and pins, are still handled by GCodeParam.
+    class GCodeParamIndex : public Configuration::HandlerBase {
+    private:
+        using index_t = std::unordered_map<std::string_view, GCodeParamItem, string_util::hash_ignore_case, string_util::equal_to_ignore_case>;
+
+        static index_t                 _index;
+        static std::deque<std::string> _paths;  // Storage for the keys of _index
+
+        std::string _path;  // Of the current section, with a trailing /
+
+        void add(const char* name, GCodeParamItem::Type type, void* value, double minValue = 0, double maxValue = 0);
+
+    protected:
+        void enterSection(const char* name, Configuration::Configurable* value) override;
+        bool matchesUninitialized(const char* name) override { return false; }
+
+    public:
+        void item(const char* name, bool& value) override { add(name, GCodeParamItem::Bool, &value); }
+        void item(const char* name, int32_t& value, const int32_t minValue, const int32_t maxValue) override {
+            add(name, GCodeParamItem::Int32, &value);
+        }
+        void item(const char* name, uint8_t& value, const uint8_t minValue, const uint8_t maxValue) override {
+            add(name, GCodeParamItem::UInt8, &value);
+        }
+        void item(const char* name, uint32_t& value, const uint32_t minValue, const uint32_t maxValue) override {
+            add(name, GCodeParamItem::UInt32, &value, minValue, maxValue);
+        }
+        void item(const char* name, float& value, const float minValue, const float maxValue) override {
+            add(name, GCodeParamItem::Float, &value, minValue, maxValue);
+        }
+        void item(const char* name, int& value, const EnumItem* e) override { add(name, GCodeParamItem::Enum, &value); }
+
+        void item(const char* name, std::vector<speedEntry>& value) override {}
+        void item(const char* name, std::vector<float>& value) override {}
+        void item(const char* name, UartData& wordLength, UartParity& parity, UartStop& stopBits) override {}
+        void item(const char* name, std::string& value, const int minLength, const int maxLength) override {}
+        void item(const char* name, EventPin& value) override {}
+        void item(const char* name, Pin& value) override {}
+        void item(const char* name, IPAddress& value) override {}
+        void item(const char* name, Macro& value) override {}
+
+        HandlerType handlerType() override { return HandlerType::Runtime; }
+
+        // Replaces the index with one for the tree under root.  Items found with
+        // find() are valid until the next build().
+        static void build(Configurable* root);
+
+        // Returns the item for a path such as /axes/x/steps_per_mm, in either case,
+        // or nullptr if it is not in the index
+        static const GCodeParamItem* find(std::string_view path);
+    };
+}
@@ -37,8 +37,6 @@
 
 #include "Expression.h"
 
-#define MAX_STACK 7
-
 typedef enum {
     Binary_NoOp = 0,
     Binary_DividedBy,
@@ -129,9 +127,6 @@ static Error execute_binary1(float& lhs, ngc_binary_op_t operation, const float&
             status = Error::ExpressionUnknownOp;
     }
 
-    if (status != Error::Ok)
-        report_param_error(status);
-
     return status;
 }
 
@@ -255,7 +250,7 @@ static Error execute_unary(float& operand, ngc_unary_op_t operation) {
             break;
 
         case Unary_Exists:
-            // do nothing here, result for the EXISTS function is set by read_unary()
+            // do nothing here, result for the EXISTS function is set by ExpressionCode::evaluate()
             break;
 
         case Unary_EXP:
@@ -608,45 +603,162 @@ static Error read_operation_unary(const char* line, size_t& pos, ngc_unary_op_t&
     return status;
 }
 
-/*! \brief Reads a slash and the second argument to the ATAN function,
-starting at the index given by the pos offset. Then it computes the value
-of the ATAN operation applied to the two arguments.
 
-\param line pointer to RS274/NGC code (block).
-\param pos offset into line where expression starts.
-\param value pointer to float where result is to be stored.
-\returns #Error::Ok enum value if processed without error, appropriate \ref Error enum value if not.
+void ExpressionCode::push(float value) {
+    _ops.push_back({ Push, 0, 0, value });
+    if (++_depth > _maxDepth) {
+        _maxDepth = _depth;
+    }
+}
+
+void ExpressionCode::push_param(const param_ref_t& param_ref, Opcode code) {
+    _ops.push_back({ code, 0, uint16_t(_params.size()), 0.0f });
+    _params.push_back(param_ref);
+    if (++_depth > _maxDepth) {
+        _maxDepth = _depth;
+    }
+}
+
+/*! \brief Adds an operation on the values at the top of the stack, or does it now
+if those values are constants.  An operation that fails is left for evaluate() to
+report.
+
+\param code \ref Opcode value.
+\param operation \ref ngc_unary_op_t or \ref ngc_binary_op_t enum value.
 */
-static Error read_atan(const char* line, size_t& pos, float& value) {
-    float argument2;
+void ExpressionCode::emit(Opcode code, uint8_t operation) {
+    size_t n      = _ops.size();
+    bool   const1 = n >= 1 && _ops[n - 1].code == Push;
+    bool   const2 = const1 && n >= 2 && _ops[n - 2].code == Push;
+
+    switch (code) {
+        case Indirect:
+            if (const1) {
+                ngc_param_id_t id = _ops[n - 1].value;
+                _ops.pop_back();
+                --_depth;
+                push_param({ "", id });
+                return;
+            }
+            break;
 
-    if (line[pos] != '/')
-        return Error::ExpressionSyntaxError;  // Slash missing after first ATAN argument
+        case Negate:
+            if (const1) {
+                _ops[n - 1].value = -_ops[n - 1].value;
+                return;
+            }
+            break;
 
-    pos++;
+        case Unary:
+            if (const1) {
+                float value = _ops[n - 1].value;
+                if (execute_unary(value, ngc_unary_op_t(operation)) == Error::Ok) {
+                    _ops[n - 1].value = value;
+                    return;
+                }
+            }
+            break;
 
-    if (line[pos] != '[')
-        return Error::ExpressionSyntaxError;  // Left bracket missing after slash with ATAN;
+        case Atan:
+            if (const2) {
+                _ops[n - 2].value = atan2f(_ops[n - 2].value, _ops[n - 1].value) * DEGRAD;
+                _ops.pop_back();
+                --_depth;
+                return;
+            }
+            break;
 
-    Error status;
+        case Binary:
+            if (const2) {
+                float value = _ops[n - 2].value;
+                if (execute_binary(value, ngc_binary_op_t(operation), _ops[n - 1].value) == Error::Ok) {
+                    _ops[n - 2].value = value;
+                    _ops.pop_back();
+                    --_depth;
+                    return;
+                }
+            }
+            break;
 
-    if ((status = expression(line, pos, argument2)) == Error::Ok)
-        value = atan2f(value, argument2) * DEGRAD; /* value in radians, convert to degrees */
+        default:
+            break;
+    }
 
-    return status;
+    _ops.push_back({ code, operation, 0, 0.0f });
+    if (code == Atan || code == Binary) {
+        --_depth;
+    }
 }
 
-/*! \brief Reads the value out of an unary operation of the line, starting at the
+/*! \brief Compiles the part of a parameter reference after the #, leaving code that
+pushes the value of the parameter.
+
+\param line pointer to RS274/NGC code (block).
+\param pos offset into line where the reference starts.
+\returns true if the reference was compiled.
+*/
+bool ExpressionCode::compile_param(const char* line, size_t& pos) {
+    char c = line[pos];
+
+    switch (c) {
+        case '#':
+            // Indirection resulting in param number
+            ++pos;
+            if (!compile_param(line, pos)) {
+                return false;
+            }
+            emit(Indirect);
+            return true;
+        case '<': {
+            // Named parameter
+            param_ref_t param_ref;
+            ++pos;
+            while ((c = line[pos]) && c != '>') {
+                ++pos;
+                if (!isspace(c)) {
+                    param_ref.name += toupper(c);
+                }
+            }
+            if (!c) {
+                log_debug("Missing >");
+                return false;
+            }
+            ++pos;
+            resolve_param(param_ref);
+            push_param(param_ref);
+            return true;
+        }
+        case '[': {
+            // Expression evaluating to param number
+            Error status = compile_expression(line, pos);
+            if (status != Error::Ok) {
+                log_debug(errorString(status));
+                return false;
+            }
+            emit(Indirect);
+            return true;
+        }
+        default: {
+            // Param number
+            float result;
+            if (!read_float(line, pos, result)) {
+                return false;
+            }
+            push_param({ "", ngc_param_id_t(result) });
+            return true;
+        }
+    }
+}
+
+/*! \brief Compiles an unary operation and its argument, starting at the
 index given by the pos offset. The ATAN operation is
 handled specially because it is followed by two arguments.
 
 \param line pointer to RS274/NGC code (block).
-\param pos offset into line where expression starts.
-\param value pointer to float where result is to be stored.
-\returns #Error::Ok enum value if processed without error, appropriate \ref Error enum value if not.
+\param pos offset into line where the operation name starts.
+\returns #Error::Ok enum value if compiled without error, appropriate \ref Error enum value if not.
 */
-// cppcheck-suppress unusedFunction
-Error read_unary(const char* line, size_t& pos, float& value) {
+Error ExpressionCode::compile_function(const char* line, size_t& pos) {
     ngc_unary_op_t operation;
     Error          status;
 
@@ -668,72 +780,230 @@ Error read_unary(const char* line, size_t& pos, float& value) {
             return Error::ExpressionSyntaxError;
         }
         ++pos;
-        value = named_param_exists(arg) ? 1.0 : 0.0;
+        push_param({ arg, 0 }, Exists);
         return Error::Ok;
     }
-    if ((status = expression(line, pos, value)) != Error::Ok) {
+    if ((status = compile_expression(line, pos)) != Error::Ok) {
         return status;
     }
     if (operation == Unary_ATAN) {
-        return read_atan(line, pos, value);
+        if (line[pos] != '/') {
+            return Error::ExpressionSyntaxError;  // Slash missing after first ATAN argument
+        }
+        pos++;
+        if (line[pos] != '[') {
+            return Error::ExpressionSyntaxError;  // Left bracket missing after slash with ATAN;
+        }
+        if ((status = compile_expression(line, pos)) != Error::Ok) {
+            return status;
+        }
+        emit(Atan);
+        return Error::Ok;
+    }
+    emit(Unary, operation);
+    return Error::Ok;
+}
+
+/*! \brief Compiles a number, a parameter, a function or a bracketed expression,
+with any leading signs.
+
+\param line pointer to RS274/NGC code (block).
+\param pos offset into line where the operand starts.
+\returns true if the operand was compiled.
+*/
+bool ExpressionCode::compile_operand(const char* line, size_t& pos) {
+    char c = line[pos];
+    if (c == '#') {
+        ++pos;
+        return compile_param(line, pos);
+    }
+    if (c == '[') {
+        Error status = compile_expression(line, pos);
+        if (status != Error::Ok) {
+            log_debug(errorString(status));
+            return false;
+        }
+        return true;
+    }
+    if (isalpha(c)) {
+        // Functions are available only inside expressions because
+        // their names conflict with GCode words
+        return compile_function(line, pos) == Error::Ok;
+    }
+    if (c == '-') {
+        ++pos;
+        if (!compile_operand(line, pos)) {
+            return false;
+        }
+        emit(Negate);
+        return true;
+    }
+    if (c == '+') {
+        ++pos;
+        return compile_operand(line, pos);
     }
-    return execute_unary(value, operation);
+    float value;
+    if (!read_float(line, pos, value)) {
+        return false;
+    }
+    push(value);
+    return true;
 }
 
-/*! \brief Evaluate expression and set result if successful.
+/*! \brief Compiles a bracketed expression.  An operator is emitted once the next
+operator has the same or lower precedence, so operators of equal precedence
+associate to the left.
 
 \param line pointer to RS274/NGC code (block).
 \param pos offset into line where expression starts.
-\param value pointer to float where result is to be stored.
-\returns #Error::Ok enum value if evaluated without error, appropriate \ref Error enum value if not.
+\returns #Error::Ok enum value if compiled without error, appropriate \ref Error enum value if not.
 */
-Error expression(const char* line, size_t& pos, float& value) {
-    float           values[MAX_STACK];
-    ngc_binary_op_t operators[MAX_STACK];
-    uint_fast8_t    stack_index = 1;
+Error ExpressionCode::compile_expression(const char* line, size_t& pos) {
+    // Each waiting operator has a higher precedence than the one before it,
+    // so there are at most as many as there are precedence levels
+    ngc_binary_op_t operators[6];
+    size_t          n = 0;
 
     if (line[pos] != '[')
         return Error::GcodeUnsupportedCommand;
 
     pos++;
 
-    Error status;
+    for (;;) {
+        if (!compile_operand(line, pos))
+            return Error::BadNumberFormat;
 
-    if ((!read_number(line, pos, values[0], true)))
-        return Error::BadNumberFormat;
+        ngc_binary_op_t operation;
+        Error           status;
 
-    if ((status = read_operation(line, pos, operators[0])) != Error::Ok)
-        return status;
+        if ((status = read_operation(line, pos, operation)) != Error::Ok)
+            return status;
 
-    for (; operators[0] != Binary_RightBracket;) {
-        if ((!read_number(line, pos, values[stack_index], true)))
-            return Error::BadNumberFormat;
+        while (n && precedence(operation) <= precedence(operators[n - 1])) {
+            emit(Binary, operators[--n]);
+        }
+        if (operation == Binary_RightBracket)
+            return Error::Ok;
 
-        if ((status = read_operation(line, pos, operators[stack_index])) != Error::Ok)
-            return status;
+        operators[n++] = operation;
+    }
+}
 
-        if (precedence(operators[stack_index]) > precedence(operators[stack_index - 1]))
-            stack_index++;
-        else {  // precedence of latest operator is <= previous precedence
-            for (; precedence(operators[stack_index]) <= precedence(operators[stack_index - 1]);) {
-                if ((status = execute_binary(values[stack_index - 1], operators[stack_index - 1], values[stack_index])) != Error::Ok)
-                    return status;
+Error ExpressionCode::compile(const char* line, size_t& pos) {
+    _ops.clear();
+    _params.clear();
+    _depth    = 0;
+    _maxDepth = 0;
+    return compile_expression(line, pos);
+}
 
-                operators[stack_index - 1] = operators[stack_index];
-                // auto o1 = operators[stack_index - 1];
-                // auto o2 = operators[stack_index - 2];
-                // auto p1 = precedence(o1);
-                // auto p2 = precedence(o1);
-                // if ((stack_index > 1) && p1 <= p2)
-                if ((stack_index > 1) && precedence(operators[stack_index - 1]) <= precedence(operators[stack_index - 2]))
-                    stack_index--;
-                else
-                    break;
-            }
+/*! \brief Evaluates a compiled expression and sets result if successful.
+
+\param value pointer to float where result is to be stored.
+\returns #Error::Ok enum value if evaluated without error, appropriate \ref Error enum value if not.
+*/
+Error ExpressionCode::evaluate(float& value) const {
+    static std::vector<float> stack;
+    if (stack.size() < _maxDepth) {
+        stack.resize(_maxDepth);
+    }
+    float* sp = stack.data();  // Next free entry
+
+    Error status;
+    for (const auto& op : _ops) {
+        switch (op.code) {
+            case Push:
+                *sp++ = op.value;
+                break;
+
+            case Param:
+                if (!get_param(_params[op.index], *sp)) {
+                    log_debug("Undefined parameter " << _params[op.index].name);
+                    return Error::BadNumberFormat;
+                }
+                ++sp;
+                break;
+
+            case Indirect:
+                if (!get_param({ "", ngc_param_id_t(sp[-1]) }, sp[-1])) {
+                    log_debug("Undefined parameter");
+                    return Error::BadNumberFormat;
+                }
+                break;
+
+            case Exists:
+                *sp++ = named_param_exists(_params[op.index].name) ? 1.0 : 0.0;
+                break;
+
+            case Negate:
+                sp[-1] = -sp[-1];
+                break;
+
+            case Unary:
+                if ((status = execute_unary(sp[-1], ngc_unary_op_t(op.operation))) != Error::Ok) {
+                    report_param_error(status);
+                    return status;
+                }
+                break;
+
+            case Atan:
+                --sp;
+                sp[-1] = atan2f(sp[-1], sp[0]) * DEGRAD; /* value in radians, convert to degrees */
+                break;
+
+            case Binary:
+                --sp;
+                if ((status = execute_binary(sp[-1], ngc_binary_op_t(op.operation), sp[0])) != Error::Ok) {
+                    report_param_error(status);
+                    return status;
+                }
+                break;
         }
     }
 
-    value = values[0];
+    value = stack[0];
 
     return Error::Ok;
 }
+
+// The parser sees the same expressions again and again in loops and in macros that
+// are run often, so the most recently compiled ones are kept.  The code depends
+// only on the text, and compiling stops at the closing bracket, so a cached
+// expression matches any line that continues with its text.
+static const int cacheSize = 8;
+
+static struct {
+    std::string    text;
+    ExpressionCode code;
+} cache[cacheSize];
+static int cacheNext = 0;
+
+/*! \brief Evaluate expression and set result if successful.
+
+\param line pointer to RS274/NGC code (block).
+\param pos offset into line where expression starts.
+\param value pointer to float where result is to be stored.
+\returns #Error::Ok enum value if evaluated without error, appropriate \ref Error enum value if not.
+*/
+Error expression(const char* line, size_t& pos, float& value) {
+    const char* text = line + pos;
+    for (const auto& entry : cache) {
+        if (entry.text.length() && !strncmp(text, entry.text.c_str(), entry.text.length())) {
+            pos += entry.text.length();
+            return entry.code.evaluate(value);
+        }
+    }
+
+    // Reuse the storage of the oldest entry
+    auto& entry = cache[cacheNext];
+    cacheNext   = (cacheNext + 1) % cacheSize;
+
+    size_t start  = pos;
+    Error  status = entry.code.compile(line, pos);
+    if (status != Error::Ok) {
+        entry.text.clear();
+        return status;
+    }
+    entry.text.assign(text, pos - start);
+    return entry.code.evaluate(value);
+}
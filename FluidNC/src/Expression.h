@@ -1,3 +1,52 @@
 #pragma once
+
+#include "Error.h"
+#include "Parameters.h"  // param_ref_t
+
+#include <cstdint>
+#include <vector>
+
+// An expression compiled to a list of operations on a stack of values, so that it
+// can be evaluated again without reading its text.  Operations on constants are
+// done when compiling, and parameter references are parsed then, but the values
+// of parameters are read each time the expression is evaluated.
+class ExpressionCode {
+    enum Opcode : uint8_t {
+        Push,      // value
+        Param,     // Value of _params[index]
+        Indirect,  // Value of the parameter whose number is on the stack
+        Exists,    // Whether _params[index] is defined
+        Negate,
+        Unary,   // operation
+        Atan,    // ATAN[a]/[b]
+        Binary,  // operation
+    };
+    struct op_t {
+        Opcode   code;
+        uint8_t  operation;
+        uint16_t index;
+        float    value;
+    };
+
+    std::vector<op_t>        _ops;
+    std::vector<param_ref_t> _params;
+    size_t                   _depth    = 0;  // Values on the stack after _ops
+    size_t                   _maxDepth = 0;
+
+    Error compile_expression(const char* line, size_t& pos);
+    bool  compile_operand(const char* line, size_t& pos);
+    bool  compile_param(const char* line, size_t& pos);
+    Error compile_function(const char* line, size_t& pos);
+
+    void push(float value);
+    void push_param(const param_ref_t& param_ref, Opcode code = Param);
+    void emit(Opcode code, uint8_t operation = 0);
+
+public:
+    // Compiles the bracketed expression at line[pos] and advances pos past it
+    Error compile(const char* line, size_t& pos);
+
+    Error evaluate(float& value) const;
+};
+
 Error expression(const char* line, size_t& pos, float& value);
-Error read_unary(const char* line, size_t& pos, float& value);
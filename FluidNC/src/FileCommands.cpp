@@ -12,6 +12,7 @@
 #include "src/string_util.h"  // split_prefix()
 
 #include "src/HashFS.h"
+#include "src/GCodeCache.h"  // GCodeCache::lookup()
 
 #include <charconv>
 
@@ -38,7 +39,8 @@ static Error formatLocalFS(const char* parameter, AuthenticationLevel auth_level
     return Error::Ok;
 }
 
-static Error openFile(const char* fs, const char* parameter, Channel& out, InputFile*& theFile) {
+// If useCache is true and GCodeCache has an up-to-date compiled copy of the file, opens that instead
+static Error openFile(const char* fs, const char* parameter, Channel& out, InputFile*& theFile, bool useCache = false) {
     if (*parameter == '\0') {
         log_string(out, "Missing file name!");
         return Error::InvalidValue;
@@ -49,7 +51,16 @@ static Error openFile(const char* fs, const char* parameter, Channel& out, Input
     }
 
     try {
-        theFile = new InputFile(fs, path.c_str());
+        size_t      start;
+        std::string cachePath;
+        if (useCache) {
+            cachePath = GCodeCache::lookup(fs, path.c_str(), start);
+        }
+        if (cachePath.empty()) {
+            theFile = new InputFile(fs, path.c_str());
+        } else {
+            theFile = new InputFile(fs, cachePath.c_str(), path.c_str(), start);
+        }
     } catch (Error err) { return err; }
     return Error::Ok;
 }
@@ -252,7 +263,7 @@ static Error runFile(const char* fs, const char* parameter, AuthenticationLevel
     }
     Job::save();
     InputFile* theFile;
-    if ((err = openFile(fs, parameter, out, theFile)) != Error::Ok) {
+    if ((err = openFile(fs, parameter, out, theFile, true)) != Error::Ok) {
         Job::restore();
         return err;
     }
@@ -448,7 +459,7 @@ static Error renameObject(const char* fs, const char* parameter, AuthenticationL
     if (!parameter || *parameter == '\0') {
         return Error::InvalidValue;
     }
-    auto opath = strchr(parameter, '>');
+    auto opath = const_cast<char*>(strchr(parameter, '>'));
     if (*opath == '\0') {
         return Error::InvalidValue;
     }
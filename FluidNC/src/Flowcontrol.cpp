@@ -36,16 +36,16 @@ typedef enum {
 } ngc_cmd_t;
 
 typedef struct {
-    uint32_t    o_label;
-    ngc_cmd_t   operation;
-    JobSource*  file;
-    size_t      file_pos;
-    size_t      line_number;
-    std::string expr;
-    uint32_t    repeats;
-    bool        skip;
-    bool        handled;
-    bool        brk;
+    uint32_t       o_label;
+    ngc_cmd_t      operation;
+    JobSource*     file;
+    size_t         file_pos;
+    size_t         line_number;
+    ExpressionCode condition;  // Of a while loop, evaluated at its end
+    uint32_t       repeats;
+    bool           skip;
+    bool           handled;
+    bool           brk;
 } ngc_stack_entry_t;
 
 std::stack<ngc_stack_entry_t> context;
@@ -82,7 +82,7 @@ static Error read_command(const char* line, size_t& pos, ngc_cmd_t& operation) {
 }
 
 static Error stack_push(uint32_t o_label, ngc_cmd_t operation, bool skip) {
-    ngc_stack_entry_t ent = { o_label, operation, Job::source(), 0, 0, "", 0, skip, false, false };
+    ngc_stack_entry_t ent = { o_label, operation, Job::source(), 0, 0, {}, 0, skip, false, false };
     context.push(ent);
     return Error::Ok;
 }
@@ -182,7 +182,7 @@ Error flowcontrol(uint32_t o_label, const char* line, size_t& pos, bool& skip) {
 
         case Op_While:
             if (Job::active()) {
-                const char* expr = line + pos;
+                size_t start = pos;
                 if (!context.empty() && context.top().brk) {
                     if (last_op == Op_Do && o_label == context.top().o_label) {
                         stack_pull();
@@ -200,7 +200,7 @@ Error flowcontrol(uint32_t o_label, const char* line, size_t& pos, bool& skip) {
                     } else {
                         stack_push(o_label, operation, !value);
                         if (value) {
-                            context.top().expr        = expr;
+                            context.top().condition.compile(line, start);
                             context.top().file        = Job::source();
                             context.top().file_pos    = context.top().file->position();
                             context.top().line_number = context.top().file->lineNumber();
@@ -216,8 +216,7 @@ Error flowcontrol(uint32_t o_label, const char* line, size_t& pos, bool& skip) {
             if (Job::active()) {
                 if (last_op == Op_While) {
                     if (!skipping && o_label == context.top().o_label) {
-                        uint_fast8_t pos = 0;
-                        if (!context.top().skip && (status = expression(context.top().expr.c_str(), pos, value)) == Error::Ok) {
+                        if (!context.top().skip && (status = context.top().condition.evaluate(value)) == Error::Ok) {
                             if (!(context.top().skip = value == 0)) {
                                 context.top().file->set_position(context.top().file_pos);
                             }
@@ -311,8 +310,7 @@ Error flowcontrol(uint32_t o_label, const char* line, size_t& pos, bool& skip) {
                                 break;
 
                             case Op_While: {
-                                uint_fast8_t pos = 0;
-                                if (!context.top().skip && (status = expression(context.top().expr.c_str(), pos, value)) == Error::Ok) {
+                                if (!context.top().skip && (status = context.top().condition.evaluate(value)) == Error::Ok) {
                                     if (!(context.top().skip = value == 0)) {
                                         context.top().file->set_position(context.top().file_pos);
                                         context.top().file->setLineNumber(context.top().line_number);
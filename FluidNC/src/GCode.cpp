@@ -50,6 +50,7 @@ gc_modal_t modal_defaults = {
     // CutterCompensation::Disable,
     ToolLengthOffset::Cancel,
     CoordIndex::G54,
+    ControlMode::ExactPath,
     ProgramFlow::Running,
     {}, // 0, // CoolantState::M7,
     SpindleState::Disable,
@@ -236,15 +237,19 @@ void gc_wco_changed() {
 // In this function, all units and positions are converted and
 // exported to internal functions in terms of (mm, mm/min) and absolute machine
 // coordinates, respectively.
-Error gc_execute_line(const char* input_line) {
+Error gc_execute_line(const char* input_line, const gc_words_t* words) {
     char line[128];
-    if (strlen(input_line) > 127) {
-        return Error::LineLengthExceeded;
-    }
-    strcpy(line, input_line);
+    if (words) {
+        line[0] = '\0';  // Already collapsed and split into words
+    } else {
+        if (strlen(input_line) > 127) {
+            return Error::LineLengthExceeded;
+        }
+        strcpy(line, input_line);
 
-    // Step 0 - remove whitespace and comments and convert to upper case
-    collapseGCode(line);
+        // Step 0 - remove whitespace and comments and convert to upper case
+        collapseGCode(line);
+    }
 
     /* -------------------------------------------------------------------------------------
        STEP 1: Initialize parser block struct and copy current g-code state modes. The parser
@@ -303,31 +308,40 @@ Error gc_execute_line(const char* input_line) {
     float      value;
     int32_t    int_value = 0;
     int32_t    mantissa  = 0;
+    size_t     word      = 0;
     pos                  = jogMotion ? 3 : 0;  // Start parsing after `$J=` if jogging
-    while ((letter = line[pos]) != '\0') {     // Loop until no more g-code words in line.
-        if (letter == '#') {
-            if (gc_state.skip_blocks) {
-                return Error::Ok;
-            }
-            pos++;
-            if (!assign_param(line, pos)) {
-                return Error::BadNumberFormat;
+    // Loop until no more g-code words in line.
+    while (words ? word < words->n : (letter = line[pos]) != '\0') {
+        if (words) {
+            // Cached lines have no parameters, expressions or flow control
+            letter = words->word[word].letter;
+            value  = words->word[word].value;
+            ++word;
+        } else {
+            if (letter == '#') {
+                if (gc_state.skip_blocks) {
+                    return Error::Ok;
+                }
+                pos++;
+                if (!assign_param(line, pos)) {
+                    return Error::BadNumberFormat;
+                }
+                continue;
             }
-            continue;
-        }
 
-        // XXX Should check that no other words are also present
-        if (bitnum_is_true(value_words, GCodeWord::O)) {
-            return flowcontrol(gc_block.values.o, line, pos, gc_state.skip_blocks);
-        }
+            // XXX Should check that no other words are also present
+            if (bitnum_is_true(value_words, GCodeWord::O)) {
+                return flowcontrol(gc_block.values.o, line, pos, gc_state.skip_blocks);
+            }
 
-        // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
-        if ((letter < 'A') || (letter > 'Z')) {
-            return Error::ExpectedCommandLetter;  // [Expected word letter]
-        }
-        pos++;
-        if (!read_number(line, pos, value)) {
-            return Error::BadNumberFormat;  // [Expected word value]
+            // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
+            if ((letter < 'A') || (letter > 'Z')) {
+                return Error::ExpectedCommandLetter;  // [Expected word letter]
+            }
+            pos++;
+            if (!read_number(line, pos, value)) {
+                return Error::BadNumberFormat;  // [Expected word value]
+            }
         }
         if (gc_state.skip_blocks && letter != 'O') {
             return Error::Ok;
@@ -583,8 +597,12 @@ Error gc_execute_line(const char* input_line) {
                         if (mantissa != 0) {
                             return Error::GcodeUnsupportedCommand;  // [G61.1 not supported]
                         }
-                        // gc_block.modal.control = ControlMode::ExactPath; // G61
-                        mg_word_bit = ModalGroup::MG13;
+                        gc_block.modal.control = ControlMode::ExactPath;  // G61
+                        mg_word_bit            = ModalGroup::MG13;
+                        break;
+                    case 64:
+                        gc_block.modal.control = ControlMode::Continuous;  // G64
+                        mg_word_bit            = ModalGroup::MG13;
                         break;
                     default:
                         return Error::GcodeUnsupportedCommand;  // [Unsupported G command]
@@ -1127,7 +1145,39 @@ Error gc_execute_line(const char* input_line) {
             coords[gc_block.modal.coord_select]->get(block_coord_system);
         }
     }
-    // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
+    // [16. Set path control mode ]: G61.1 NOT SUPPORTED. P and Q words are optional for G64 and not allowed for G61.
+    // P is the blending tolerance and Q the merging tolerance. Without P, the junction deviation is used, and
+    // without Q, the P value.
+    float path_tolerance  = gc_state.path_tolerance;
+    float merge_tolerance = gc_state.merge_tolerance;
+    if (bitnum_is_true(command_words, ModalGroup::MG13)) {
+        if (gc_block.modal.control == ControlMode::Continuous) {
+            path_tolerance = config->_junctionDeviation;
+            if (bitnum_is_true(value_words, GCodeWord::P)) {
+                if (gc_block.values.p < 0.0) {
+                    return Error::NegativeValue;
+                }
+                path_tolerance = gc_block.values.p;
+                if (gc_block.modal.units == Units::Inches) {
+                    path_tolerance *= MM_PER_INCH;
+                }
+            }
+            merge_tolerance = path_tolerance;
+            if (bitnum_is_true(value_words, GCodeWord::Q)) {
+                if (gc_block.values.q < 0.0) {
+                    return Error::NegativeValue;
+                }
+                merge_tolerance = gc_block.values.q;
+                if (gc_block.modal.units == Units::Inches) {
+                    merge_tolerance *= MM_PER_INCH;
+                }
+            }
+            clear_bits(value_words, (bitnum_to_mask(GCodeWord::P) | bitnum_to_mask(GCodeWord::Q)));
+        } else {
+            path_tolerance  = 0.0;
+            merge_tolerance = 0.0;
+        }
+    }
     // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
     // [18. Set retract mode ]: NOT SUPPORTED.
     // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
@@ -1581,8 +1631,12 @@ Error gc_execute_line(const char* input_line) {
         }
     }
     // [0. Non-specific/common error-checks and miscellaneous setup]:
-    // NOTE: If no line number is present, the value is zero.
+    // NOTE: If no line number is present, the value is zero, except in a file job, where it is the
+    // line number in the file so that Ln: and underrun reports can locate the line.
     gc_state.line_number = gc_block.values.n;
+    if (gc_state.line_number == 0 && Job::active()) {
+        gc_state.line_number = Job::channel()->lineNumber();
+    }
     pl_data->line_number = gc_state.line_number;  // Record data for planner use.
 
     // [1. Comments feedback ]:  NOT SUPPORTED
@@ -1787,8 +1841,12 @@ Error gc_execute_line(const char* input_line) {
         copyAxes(gc_state.coord_system, block_coord_system);
         gc_wco_changed();
     }
-    // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
-    // gc_state.modal.control = gc_block.modal.control; // NOTE: Always default.
+    // [16. Set path control mode ]: G61.1 NOT SUPPORTED
+    gc_state.modal.control   = gc_block.modal.control;
+    gc_state.path_tolerance  = path_tolerance;
+    gc_state.merge_tolerance = merge_tolerance;
+    pl_data->path_tolerance  = path_tolerance;
+    pl_data->merge_tolerance = merge_tolerance;
     // [17. Set distance mode ]:
     gc_state.modal.distance = gc_block.modal.distance;
     // [18. Set retract mode ]: NOT SUPPORTED
@@ -1970,7 +2028,7 @@ Error gc_execute_line(const char* input_line) {
    group 8 = {M7*} enable mist coolant (* Compile-option)
    group 9 = {M48, M49} enable/disable feed and speed override switches
    group 10 = {G98, G99} return mode canned cycles
-   group 13 = {G61.1, G64} path control mode (G61 is supported)
+   group 13 = {G61.1} path control mode (G61 and G64 are supported)
 */
 
 static std::optional<WaitOnInputMode> validate_wait_on_input_mode_value(uint8_t value) {
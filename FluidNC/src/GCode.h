@@ -39,7 +39,7 @@ enum class ModalGroup : uint8_t {
     MG7  = 7,   // [G40] Cutter radius compensation mode. G41/42 NOT SUPPORTED.
     MG8  = 8,   // [G43.1,G49] Tool length offset
     MG12 = 9,   // [G54,G55,G56,G57,G58,G59] Coordinate system selection
-    MG13 = 10,  // [G61] Control mode
+    MG13 = 10,  // [G61,G64] Control mode
     // Table 6. M-code Modal Groups
     MM4  = 11,  // [M0,M1,M2,M30] Stopping
     MM5  = 12,  // [M62,M63,M64,M65,M66,M67,M68] Digital/analog output/input
@@ -133,7 +133,8 @@ enum class CutterCompensation : gcodenum_t {
 
 // Modal Group G13: Control mode
 enum class ControlMode : gcodenum_t {
-    ExactPath = 610,  // G61
+    ExactPath  = 610,  // G61 Default
+    Continuous = 640,  // G64
 };
 
 // GCodeCoolant is used by the parser, where at most one of
@@ -268,16 +269,16 @@ struct gc_modal_t {
     // ArcDistance distance_arc; // {G91.1} NOTE: Don't track. Only default supported.
     Plane plane_select;  // {G17,G18,G19}
     // CutterCompensation cutter_comp;  // {G40} NOTE: Don't track. Only default supported.
-    ToolLengthOffset tool_length;   // {G43.1,G49}
-    CoordIndex       coord_select;  // {G54,G55,G56,G57,G58,G59}
-    // uint8_t control;      // {G61} NOTE: Don't track. Only default supported.
-    ProgramFlow   program_flow;  // {M0,M1,M2,M30}
-    CoolantState  coolant;       // {M7,M8,M9}
-    SpindleState  spindle;       // {M3,M4,M5}
-    ToolChange    tool_change;   // {M6}
-    SetToolNumber set_tool_number;
-    IoControl     io_control;  // {M62, M63, M67}
-    Override      override;    // {M56}
+    ToolLengthOffset tool_length;      // {G43.1,G49}
+    CoordIndex       coord_select;     // {G54,G55,G56,G57,G58,G59}
+    ControlMode      control;          // {G61,G64}
+    ProgramFlow      program_flow;     // {M0,M1,M2,M30}
+    CoolantState     coolant;          // {M7,M8,M9}
+    SpindleState     spindle;          // {M3,M4,M5}
+    ToolChange       tool_change;      // {M6}
+    SetToolNumber    set_tool_number;
+    IoControl        io_control;       // {M62, M63, M67}
+    Override         override;         // {M56}
 };
 
 struct gc_values_t {
@@ -312,6 +313,9 @@ struct parser_state_t {
     // machine zero in mm. Non-persistent. Cleared upon reset and boot.
     float tool_length_offset;  // Tracks tool length offset value when enabled.
     bool  skip_blocks;         // Skipping due to flow control
+
+    float path_tolerance;   // G64 P value in mm
+    float merge_tolerance;  // G64 Q value in mm
 };
 
 extern parser_state_t gc_state;
@@ -323,6 +327,20 @@ struct parser_block_t {
     GCodeCoolant coolant;
 };
 
+// A line of G-code that GCodeCache has already split into words, with the
+// numbers converted, so the parser can execute it without reading the text
+struct gc_words_t {
+    static const int maxWords = 24;
+
+    struct word_t {
+        char  letter;
+        float value;
+    };
+
+    uint8_t n;
+    word_t  word[maxWords];
+};
+
 enum class AxisCommand : uint8_t {
     None             = 0,
     NonModal         = 1,
@@ -333,8 +351,8 @@ enum class AxisCommand : uint8_t {
 // Initialize the parser
 void gc_init();
 
-// Execute one block of rs275/ngc/g-code
-Error gc_execute_line(const char* line);
+// Execute one block of rs275/ngc/g-code.  If words is given, line is ignored.
+Error gc_execute_line(const char* line, const gc_words_t* words = nullptr);
 
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
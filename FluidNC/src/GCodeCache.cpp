@@ -0,0 +1,201 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "GCodeCache.h"
+
+#include "Settings.h"   // WebCommand
+#include "InputFile.h"  // InputFile
+#include "HashFS.h"
+#include "NutsBolts.h"  // read_float()
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace GCodeCache {
+    static const char* suffix   = ".gcc";
+    static const char  magic[4] = { 'G', 'C', 'C', '1' };
+
+    // HashFS only hashes local files when they are written through FluidNC,
+    // so a file that it has not seen is hashed now
+    static std::string source_hash(const stdfs::path& path) {
+        std::string hash = HashFS::hash(path);
+        if (hash.empty()) {
+            HashFS::rehash_file(path, false);
+            hash = HashFS::hash(path);
+        }
+        return hash;
+    }
+
+    bool compileLine(const char* line, gc_words_t& words) {
+        // gc_execute_line() rejects longer lines, including their spaces and comments
+        if (strlen(line) > 127) {
+            return false;
+        }
+
+        // Collapse as collapseGCode() does.  Comments can print messages, % marks the
+        // ends of the file, and the others need the parser's state.
+        char   text[128];
+        size_t len = 0;
+        for (const char* p = line; *p && *p != ';'; ++p) {
+            char c = *p;
+            if (isspace(c)) {
+                continue;
+            }
+            if (strchr("()%#[$", c)) {
+                return false;
+            }
+            text[len++] = toupper(c);
+        }
+        text[len] = '\0';
+
+        words.n    = 0;
+        size_t pos = 0;
+        while (text[pos]) {
+            char letter = text[pos++];
+            if (letter < 'A' || letter > 'Z' || letter == 'O' || words.n == gc_words_t::maxWords) {
+                return false;
+            }
+            float value;
+            if (!read_float(text, pos, value)) {
+                return false;  // Let the parser report the error
+            }
+            words.word[words.n++] = { letter, value };
+        }
+        return words.n != 0;
+    }
+
+    std::string text(const gc_words_t& words) {
+        std::string s;
+        for (int i = 0; i < words.n; i++) {
+            char number[20];
+            int  len = snprintf(number, sizeof(number), "%.4f", words.word[i].value);
+            while (number[len - 1] == '0') {
+                --len;
+            }
+            if (number[len - 1] == '.') {
+                --len;
+            }
+            s += words.word[i].letter;
+            s.append(number, len);
+        }
+        return s;
+    }
+
+    static void write_record(FileStream& file, const char* line, const gc_words_t& words, bool compiled) {
+        if (compiled) {
+            file.write(words.n);
+            for (int i = 0; i < words.n; i++) {
+                file.write(words.word[i].letter);
+                file.write(reinterpret_cast<const uint8_t*>(&words.word[i].value), sizeof(float));
+            }
+        } else {
+            uint8_t len = strlen(line);
+            file.write(textTag);
+            file.write(len);
+            file.write(reinterpret_cast<const uint8_t*>(line), len);
+        }
+    }
+
+    Error compile(const char* fs, const char* path, Channel& out) {
+        std::string cachePath = std::string(path) + suffix;
+        std::string tempPath  = cachePath + ".tmp";
+        Error       err;
+        size_t      lines    = 0;
+        size_t      compiled = 0;
+        try {
+            InputFile   source(fs, path);
+            std::string hash = source_hash(source.fpath());
+            if (hash.empty()) {
+                return Error::FsFailedRead;
+            }
+            FileStream dest(tempPath, "w", fs);
+            dest.write(reinterpret_cast<const uint8_t*>(magic), sizeof(magic));
+            dest.write(uint8_t(hash.length()));
+            dest.write(reinterpret_cast<const uint8_t*>(hash.c_str()), hash.length());
+
+            char       line[Channel::maxLine + 1];
+            gc_words_t words;
+            while ((err = source.readLine(line, Channel::maxLine)) == Error::Ok) {
+                bool isCompiled = compileLine(line, words);
+                write_record(dest, line, words, isCompiled);
+                ++lines;
+                compiled += isCompiled;
+            }
+        } catch (const Error e) { return e; }
+
+        std::error_code ec;
+        FluidPath       tempFpath { tempPath, fs, ec };
+        FluidPath       cacheFpath { cachePath, fs, ec };
+        if (ec) {
+            return Error::FsFailedOpenFile;
+        }
+        if (err != Error::Eof) {
+            stdfs::remove(tempFpath, ec);
+            log_error_to(out, path << " line " << lines + 1 << ": " << errorString(err));
+            return err;
+        }
+        stdfs::rename(tempFpath, cacheFpath, ec);
+        if (ec) {
+            log_error_to(out, "Cannot create " << cachePath << ": " << ec.message());
+            return Error::FsFailedCreateFile;
+        }
+        HashFS::rehash_file(cacheFpath);
+        log_info_to(out, cachePath << ": " << compiled << " of " << lines << " lines compiled");
+        return Error::Ok;
+    }
+
+    std::string lookup(const char* fs, const char* path, size_t& start) {
+        std::string     cachePath = std::string(path) + suffix;
+        std::error_code ec;
+        FluidPath       sourceFpath { path, fs, ec };
+        FluidPath       cacheFpath { cachePath, fs, ec };
+        if (ec || !stdfs::exists(cacheFpath, ec)) {
+            return "";
+        }
+
+        char    header[sizeof(magic)];
+        uint8_t len;
+        char    hash[256];
+        try {
+            FileStream cache(cacheFpath, "r");
+            if (cache.read(header, sizeof(magic)) != sizeof(magic) || memcmp(header, magic, sizeof(magic)) ||
+                cache.read(reinterpret_cast<char*>(&len), 1) != 1 || cache.read(hash, len) != len) {
+                log_warn(cachePath << " is not a compiled file");
+                return "";
+            }
+        } catch (const Error err) { return ""; }
+
+        if (source_hash(sourceFpath) != std::string(hash, len)) {
+            log_info(cachePath << " is out of date; running " << path);
+            return "";
+        }
+        start = sizeof(magic) + 1 + len;
+        return cachePath;
+    }
+
+    static Error compileFile(const char* fs, const char* parameter, Channel& out) {
+        if (!parameter || !*parameter) {
+            log_string(out, "Missing file name!");
+            return Error::InvalidValue;
+        }
+        std::string path(parameter);
+        if (path[0] != '/') {
+            path = "/" + path;
+        }
+        return compile(fs, path.c_str(), out);
+    }
+
+    static Error compileSDFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+        return compileFile(sdName, parameter, out);
+    }
+
+    static Error compileLocalFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+        return compileFile("", parameter, out);
+    }
+}
+
+void make_gcode_cache_commands() {
+    new WebCommand("path", WEBCMD, WU, NULL, "SD/Compile", GCodeCache::compileSDFile);
+    new WebCommand("path", WEBCMD, WU, NULL, "LocalFS/Compile", GCodeCache::compileLocalFile);
+}
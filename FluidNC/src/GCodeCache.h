@@ -0,0 +1,50 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  GCodeCache.h - G-code files compiled ahead of time
+
+    $LocalFS/Compile=<file>    $SD/Compile=<file>
+
+  reads a G-code file once and writes <file>.gcc next to it, with one record per
+  line of the source.  A line that has only letters and plain numbers is stored
+  as its words, with the numbers already converted, so running it needs no text
+  parsing.  Other lines - comments, parameters, expressions, flow control and $
+  commands - are stored as text and parsed as usual.
+
+  The compiled file begins with the HashFS hash of the source.  $LocalFS/Run and
+  $SD/Run use the compiled file instead of the source if the hash still matches,
+  so editing the source makes them ignore the compiled file until it is compiled
+  again.  Files on SD are not in the HashFS cache, so checking one reads it all.
+*/
+
+#include "Error.h"
+#include "GCode.h"  // gc_words_t
+
+#include <cstdint>
+#include <string>
+
+class Channel;
+
+namespace GCodeCache {
+    // Record tags.  A tag from 1 to gc_words_t::maxWords is the number of words that
+    // follow, each a letter and a float.
+    const uint8_t textTag = 0;  // Followed by a length byte and the text
+
+    // Compiles a file.  fs is the default file system, as for InputFile.
+    Error compile(const char* fs, const char* path, Channel& out);
+
+    // Returns the path of an up-to-date compiled copy of a file, or an empty string if
+    // there is none.  start is set to the offset of the first record.
+    std::string lookup(const char* fs, const char* path, size_t& start);
+
+    // Splits a line into words.  Returns false if the line must be kept as text.
+    bool compileLine(const char* line, gc_words_t& words);
+
+    // The words of a compiled line as text, for messages
+    std::string text(const gc_words_t& words);
+}
+
+void make_gcode_cache_commands();
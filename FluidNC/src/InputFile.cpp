@@ -3,9 +3,221 @@
 
 #include "InputFile.h"
 
+#include "Config.h"  // SUPPORT_TASK_CORE
 #include "Report.h"
+#include "GCodeCache.h"  // GCodeCache::textTag
+#include "Stepper.h"  // Stepper::underrun_stats
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstring>
+
+InputFile::InputFile(const char* defaultFs, const char* path) :
+    FileStream(path, "r", defaultFs), _start_underruns(Stepper::underrun_stats.count) {}
+
+InputFile::InputFile(const char* defaultFs, const char* path, const char* source, size_t start) :
+    FileStream(path, "r", defaultFs), _start_underruns(Stepper::underrun_stats.count), _compiled(true),
+    _sourceName(FluidPath(source, defaultFs).c_str()) {
+    set_position(start);
+}
+
+// Requests to the reader task to fill a block
+struct ReadRequest {
+    InputFile*         file;
+    char*              data;
+    size_t             size;
+    size_t*            len;
+    std::atomic<bool>* busy;
+};
+
+static void reader(void* arg) {
+    auto        queue = static_cast<QueueHandle_t>(arg);
+    ReadRequest req;
+    while (true) {
+        if (xQueueReceive(queue, &req, portMAX_DELAY)) {
+            *req.len = req.file->read(req.data, req.size);
+            req.busy->store(false, std::memory_order_release);
+        }
+    }
+}
+
+static QueueHandle_t start_reader() {
+    QueueHandle_t queue = xQueueCreate(4, sizeof(ReadRequest));
+    xTaskCreatePinnedToCore(reader,            // task
+                            "filereader",      // name for task
+                            4096,              // size of task stack
+                            queue,             // parameters
+                            2,                 // priority
+                            nullptr,           // task handle
+                            SUPPORT_TASK_CORE  // core
+    );
+    return queue;
+}
+
+void InputFile::wait(Block& block) {
+    while (block.busy.load(std::memory_order_acquire)) {
+        vTaskDelay(1);
+    }
+}
+
+// Starts reading the block that follows the current one into the other buffer
+void InputFile::prefetch() {
+    static QueueHandle_t queue = start_reader();
+
+    Block& current = _blocks[_current];
+    Block& next    = _blocks[_current ^ 1];
+    next.start     = current.start + current.len;
+    if (current.len < blockSize) {
+        next.len = 0;  // The current block is the last one
+        return;
+    }
+    next.busy.store(true, std::memory_order_relaxed);
+    ReadRequest req = { this, next.data, blockSize, &next.len, &next.busy };
+    if (!xQueueSend(queue, &req, 0)) {
+        next.len = read(next.data, blockSize);
+        next.busy.store(false, std::memory_order_relaxed);
+    }
+}
+
+// Moves to the block that follows the current one.  Returns false at the end of the file.
+bool InputFile::next_block() {
+    if (_block == &_loop) {
+        // Out of the loop body and back to the file
+        load(_loop.start + _loop.len);
+        return _block->len != 0;
+    }
+    Block& next = _blocks[_current ^ 1];
+    wait(next);
+    if (_block->len < blockSize || next.len == 0) {
+        return false;
+    }
+    _current ^= 1;
+    _block  = &next;
+    _offset = 0;
+    prefetch();
+    return true;
+}
+
+// Discards the buffered data and reads the block at pos
+void InputFile::load(size_t pos) {
+    wait(_blocks[_current ^ 1]);
+    FileStream::set_position(pos);
+    _block        = &_blocks[_current];
+    _block->start = pos;
+    _block->len   = read(_block->data, blockSize);
+    _offset       = 0;
+    _loaded       = true;
+    prefetch();
+}
+
+// Reads a loop body, from pos up to end, for the passes after the first.  The file
+// offset is then not where prefetch() expects, so leaving the loop body calls load().
+void InputFile::cache_loop(size_t pos, size_t end) {
+    _loopData.resize(end - pos);
+    FileStream::set_position(pos);
+    _loop.data  = _loopData.data();
+    _loop.start = pos;
+    _loop.len   = read(_loop.data, end - pos);
+    _block      = &_loop;
+    _offset     = 0;
+}
+
+void InputFile::set_position(size_t pos) {
+    auto holds = [pos](const Block& block) { return pos >= block.start && pos < block.start + block.len; };
+    if (_loaded) {
+        if (pos >= _block->start && pos <= _block->start + _block->len) {
+            // Short loops jump back within the current block
+            _offset = pos - _block->start;
+            return;
+        }
+        Block& next = _blocks[_current ^ 1];
+        wait(next);
+        if (holds(_loop)) {
+            _block  = &_loop;
+            _offset = pos - _loop.start;
+            return;
+        }
+        if (_block != &_loop && holds(next)) {
+            _current ^= 1;
+            _block  = &next;
+            _offset = pos - next.start;
+            prefetch();
+            return;
+        }
+        size_t end = position();
+        if (pos < end && end - pos <= maxLoopBytes) {
+            cache_loop(pos, end);
+            return;
+        }
+    }
+    load(pos);
+}
+
+// Closing the file loses the buffered data, so restore() starts over at the current line
+void InputFile::save() {
+    wait(_blocks[_current ^ 1]);
+    _loaded = false;
+    FileStream::save();
+}
+
+// Copies len bytes from the file.  Returns false at the end of the file.
+bool InputFile::take(void* dest, size_t len) {
+    auto p = static_cast<char*>(dest);
+    while (len) {
+        Block& block = *_block;
+        if (_offset == block.len) {
+            if (!next_block()) {
+                return false;
+            }
+            continue;
+        }
+        size_t n = std::min(len, block.len - _offset);
+        memcpy(p, block.data + _offset, n);
+        p += n;
+        len -= n;
+        _offset += n;
+    }
+    return true;
+}
+
+// Reads one line of a compiled file.  A compiled line leaves line empty and
+// puts its words in _words.
+Error InputFile::readRecord(char* line, int maxlen) {
+    _haveWords = false;
+    line[0]    = '\0';
+
+    uint8_t tag;
+    if (!take(&tag, 1)) {
+        return Error::Eof;
+    }
+    ++_line_number;
+    if (tag == GCodeCache::textTag) {
+        uint8_t len;
+        if (!take(&len, 1) || len > maxlen || !take(line, len)) {
+            return Error::FsFailedRead;
+        }
+        line[len] = '\0';
+        if (len == 0) {
+            ++_blank_lines;
+        }
+        return Error::Ok;
+    }
+    if (tag > gc_words_t::maxWords) {
+        return Error::FsFailedRead;
+    }
+    for (int i = 0; i < tag; i++) {
+        auto& word = _words.word[i];
+        if (!take(&word.letter, 1) || !take(&word.value, sizeof(word.value))) {
+            return Error::FsFailedRead;
+        }
+    }
+    _words.n   = tag;
+    _haveWords = true;
+    return Error::Ok;
+}
 
-InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path, "r", defaultFs) {}
 /*
   Read a line from the file
   Returns Error::Ok if a line was read, even if the line was empty.
@@ -13,35 +225,58 @@ InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path,
   Returns other Error code on error, after displaying a message.
 */
 Error InputFile::readLine(char* line, int maxlen) {
+    if (!_loaded) {
+        load(position());
+    }
+    if (_compiled) {
+        return readRecord(line, maxlen);
+    }
     int len = 0;
-    int c;
-    while ((c = read()) >= 0) {
-        if (len >= maxlen) {
-            return Error::LineLengthExceeded;
-        }
-        if (c == '\r') {
+    while (true) {
+        Block& block = *_block;
+        if (_offset == block.len) {
+            if (!next_block()) {
+                break;
+            }
             continue;
         }
-        if (c == '\n') {
+        const char* p   = block.data + _offset;
+        size_t      n   = block.len - _offset;
+        auto        eol = static_cast<const char*>(memchr(p, '\n', n));
+        if (eol) {
+            n = eol - p;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (p[i] == '\r') {
+                continue;
+            }
+            if (len >= maxlen) {
+                return Error::LineLengthExceeded;
+            }
+            line[len++] = p[i];
+        }
+        _offset += n;
+        if (eol) {
+            ++_offset;
             ++_line_number;
             if (len == 0) {
                 ++_blank_lines;
             }
-            break;
+            line[len] = '\0';
+            return Error::Ok;
         }
-        line[len++] = c;
     }
     line[len] = '\0';
-    return len || c >= 0 ? Error::Ok : Error::Eof;
+    return len ? Error::Ok : Error::Eof;
 }
 
 void InputFile::ack(Error status) {
     if (status != Error::Ok) {
-        log_error(static_cast<int>(status) << " (" << errorString(status) << ") in " << name() << " at line " << lineNumber());
+        log_error(static_cast<int>(status) << " (" << errorString(status) << ") in " << sourceName() << " at line " << lineNumber());
         if (status != Error::GcodeUnsupportedCommand) {
             // Do not stop on unsupported commands because most senders do not stop.
             // Stop the file job on other errors
-            notifyf("File job error", "Error:%d in %s at line: %d", status, name(), lineNumber());
+            notifyf("File job error", "Error:%d in %s at line: %d", status, sourceName().c_str(), lineNumber());
             _pending_error == status;
         }
     }
@@ -52,8 +287,30 @@ void InputFile::ack(Error status) {
 
 void InputFile::end_message() {
     _progress = "SD: ";
-    _progress += name();
+    _progress += sourceName();
     _progress += ": Sent";
+    report_underruns();
+}
+
+// Lists the segment buffer underruns during the job, so the sections of the file that starved
+// the machine can be found.  The last few lines may still be executing, so it can miss some.
+void InputFile::report_underruns() {
+    if (_reported_underruns) {
+        return;
+    }
+    _reported_underruns = true;
+
+    auto     stats = Stepper::underrun_stats;
+    uint32_t count = stats.count - _start_underruns;
+    if (!count) {
+        return;
+    }
+    log_warn(sourceName() << ": " << count << " segment buffer underruns");
+    uint32_t n = std::min(count, uint32_t(Stepper::underrun_stats_t::LOG_SIZE));
+    for (uint32_t i = stats.count - n; i < stats.count; i++) {
+        auto& u = stats.log[i % Stepper::underrun_stats_t::LOG_SIZE];
+        log_warn("Underrun at line " << u.line_number << " " << u.usecs / 1000 << "ms");
+    }
 }
 
 Error InputFile::pollLine(char* line) {
@@ -85,7 +342,7 @@ Error InputFile::pollLine(char* line) {
             float percent_complete = ((float)position()) * 100.0f / size();
 
             std::ostringstream s;
-            s << "SD:" << std::fixed << std::setprecision(2) << percent_complete << "," << path().c_str();
+            s << "SD:" << std::fixed << std::setprecision(2) << percent_complete << "," << sourceName();
             _progress = s.str();
         }
             return Error::Ok;
@@ -98,4 +355,6 @@ Error InputFile::pollLine(char* line) {
     }
 }
 
-InputFile::~InputFile() {}
+InputFile::~InputFile() {
+    wait(_blocks[_current ^ 1]);
+}
@@ -8,6 +8,9 @@
 //  - For reporting the progress of GCode execution, counts the number of lines read and
 //    the percentage of the file size that has currently been read.
 //  - For reporting status, remembers the I/O channel that started the process of using the file.
+//  - Reads the file in blocks, with a background task reading the next block ahead,
+//    so that executing a line seldom waits for the file system.
+//  - Can instead read a file compiled by GCodeCache, returning its lines as words.
 // FileStream's Channel member is not that same Channel that FileStream ultimately
 // inherits from; rather it is a separate channel that is use for status reporting.
 
@@ -17,7 +20,9 @@
 #include "FileStream.h"  // FileStream and Channel
 #include "Error.h"
 
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 class InputFile : public FileStream {
 private:
@@ -26,11 +31,60 @@ private:
 
     size_t _blank_lines = 0;
 
+    // Underrun count when the file started, to report the ones during this job
+    uint32_t _start_underruns;
+    bool     _reported_underruns = false;
+    void     report_underruns();
+
+    // The file is read into two block buffers.  Lines are split in place in the current
+    // one while the reader task fills the other with the block that follows it.  The
+    // file offset is therefore always at the end of the block after the current one.
+    static const size_t blockSize = 1024;
+
+    // The first time that flow control jumps back to the start of a loop, the loop body
+    // is read into a third block, so the later passes do not have to read the file.
+    static const size_t maxLoopBytes = 8192;
+
+    struct Block {
+        char*             data;
+        size_t            start = 0;         // File offset of data[0]
+        size_t            len   = 0;         // Less than blockSize only at the end of the file
+        std::atomic<bool> busy { false };  // The reader task is filling it
+    };
+
+    char              _buffers[2][blockSize];
+    Block             _blocks[2] = { { _buffers[0] }, { _buffers[1] } };
+    int               _current   = 0;           // The one of _blocks that is being read or was last read
+    Block             _loop { nullptr };        // The loop body
+    std::vector<char> _loopData;                // Storage for the loop body
+    Block*            _block  = &_blocks[0];  // The block that lines come from
+    size_t            _offset = 0;            // Offset in _block of the next line
+    bool              _loaded = false;        // The blocks hold file data
+
+    void wait(Block& block);
+    void prefetch();
+    bool next_block();
+    void load(size_t pos);
+    void cache_loop(size_t pos, size_t end);
+    bool take(void* dest, size_t len);
+
+    // Reading a compiled file
+    bool        _compiled  = false;
+    bool        _haveWords = false;  // The last line read is in _words
+    gc_words_t  _words;
+    std::string _sourceName;  // The source of the compiled file, for messages
+
+    Error       readRecord(char* line, int maxlen);
+    std::string sourceName() { return _compiled ? _sourceName : name(); }
+
 public:
     // fsname is the default file system on which the file is located, in case the path does not specify
     // path is the full path to the file
     InputFile(const char* fsname, const char* path);
 
+    // Reads the file that GCodeCache compiled from source, starting at offset start
+    InputFile(const char* fsname, const char* path, const char* source, size_t start);
+
     InputFile(const InputFile&)            = delete;
     InputFile& operator=(const InputFile&) = delete;
 
@@ -52,5 +106,13 @@ public:
     void   ack(Error status) override;
     Error  pollLine(char* line) override;
 
+    // The position is that of the next line, not the file offset, which is ahead of it
+    size_t position() override { return _block->start + _offset; }
+    void   set_position(size_t pos) override;
+
+    void save() override;
+
+    const gc_words_t* compiledLine() override { return _haveWords ? &_words : nullptr; }
+
     ~InputFile();
 };
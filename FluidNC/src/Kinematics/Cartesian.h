@@ -43,6 +43,7 @@ namespace Kinematics {
         void         releaseMotors(AxisMask axisMask, MotorMask motors) override;
         bool         limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited) override;
         virtual bool kinematics_homing(AxisMask& axisMask) override;
+        bool         one_block_per_line() override { return true; }
 
         // Configuration handlers:
         void afterParse() override {}
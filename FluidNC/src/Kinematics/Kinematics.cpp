@@ -44,6 +44,11 @@ namespace Kinematics {
         return _system->kinematics_homing(axisMask);
     }
 
+    bool Kinematics::one_block_per_line() {
+        Assert(_system != nullptr, "No kinematic system");
+        return _system->one_block_per_line();
+    }
+
     void Kinematics::releaseMotors(AxisMask axisMask, MotorMask motors) {
         Assert(_system != nullptr, "No kinematic system");
         _system->releaseMotors(axisMask, motors);
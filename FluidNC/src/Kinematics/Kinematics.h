@@ -47,6 +47,7 @@ namespace Kinematics {
 
         bool canHome(AxisMask axisMask);
         bool kinematics_homing(AxisMask axisMask);
+        bool one_block_per_line();
         void releaseMotors(AxisMask axisMask, MotorMask motors);
         bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited);
 
@@ -86,6 +87,10 @@ namespace Kinematics {
         virtual bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited) { return false; }
         virtual bool kinematics_homing(AxisMask& axisMask) { return false; }
 
+        // True if cartesian_to_motors() plans every line as exactly one block, as raster
+        // scanlines require.  Systems that split lines into short segments return false.
+        virtual bool one_block_per_line() { return false; }
+
         // Configuration interface.
         void afterParse() override {}
         void group(Configuration::HandlerBase& handler) override {}
@@ -33,6 +33,7 @@ namespace Machine {
         float _stepsPerMm   = 80.0f;
         float _maxRate      = 1000.0f;
         float _acceleration = 25.0f;
+        float _jerk         = 0.0f;  // 0 for constant-acceleration (trapezoid) ramps
         float _maxTravel    = 1000.0f;
         bool  _softLimits   = false;
 
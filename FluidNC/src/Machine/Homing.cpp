@@ -352,6 +352,7 @@ namespace Machine {
         log_debug("Homing done");
 
         if (sys.abort) {
+            Stepping::endLowLatency();
             return;  // Did not complete. Alarm state set by mc_alarm.
         }
         // Homing cycle complete! Setup system for normal operation.
@@ -398,6 +399,7 @@ namespace Machine {
 
     void Homing::fail(ExecAlarm alarm) {
         Stepper::reset();  // Stop moving
+        Stepping::endLowLatency();
         send_alarm(alarm);
         Axes::set_homing_mode(_cycleAxes, false);  // tell motors homing is done...failed
         Axes::set_disable(Stepping::_idleMsecs != 255);
@@ -44,18 +44,26 @@ namespace Machine {
 
     void LimitPin::init() {
         EventPin::init();
-        _pLimited = Stepping::limit_var(_axis, _motorNum);
+    }
+
+    void LimitPin::stopMotors(bool active) {
+        if (active) {
+            Stepping::limit(_axis, _motorNum);
+            if (_extraAxis >= 0) {
+                Stepping::limit(_extraAxis, _extraMotorNum);
+            }
+        } else {
+            Stepping::unlimit(_axis, _motorNum);
+            if (_extraAxis >= 0) {
+                Stepping::unlimit(_extraAxis, _extraMotorNum);
+            }
+        }
     }
 
     void LimitPin::trigger(bool active) {
         if (active) {
             if (Homing::approach() || (!state_is(State::Homing) && _pHardLimits)) {
-                if (_pLimited != nullptr) {
-                    *_pLimited = active;
-                }
-                if (_pExtraLimited != nullptr) {
-                    *_pExtraLimited = active;
-                }
+                stopMotors(true);
             }
 
             if (_posLimits != nullptr) {
@@ -65,12 +73,7 @@ namespace Machine {
                 set_bits(*_negLimits, _bitmask);
             }
         } else {
-            if (_pLimited != nullptr) {
-                *_pLimited = active;
-            }
-            if (_pExtraLimited != nullptr) {
-                *_pExtraLimited = active;
-            }
+            stopMotors(false);
             if (_posLimits != nullptr) {
                 clear_bits(*_posLimits, _bitmask);
             }
@@ -89,6 +92,7 @@ namespace Machine {
     }
 
     void LimitPin::setExtraMotorLimit(int axis, int motorNum) {
-        _pExtraLimited = Stepping::limit_var(axis, motorNum);
+        _extraAxis     = axis;
+        _extraMotorNum = motorNum;
     }
 }
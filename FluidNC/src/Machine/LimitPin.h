@@ -4,6 +4,11 @@
 
 namespace Machine {
     class LimitPin : public EventPin {
+    public:
+        // Declared before _pHardLimits, in the order of the constructor's initializer list
+        int _axis;
+        int _motorNum;
+
     private:
         uint32_t _bitmask = 0;
 
@@ -12,18 +17,19 @@ namespace Machine {
         // limit behavior dynamically.
         bool& _pHardLimits;
 
-        // _pLimited is a reference to the _limited member of
-        // the Motor class.  Setting it when the Limit ISR fires
-        // lets the motor driver respond rapidly to a limit switch
+        // The Limit ISR stops the motor through Stepping::limit(),
+        // which lets the motor driver respond rapidly to a limit switch
         // touch, increasing the accuracy of homing
-        // _pExtraLimited lets the limit control two motors, as with
-        // CoreXY
-        volatile bool* _pLimited;
-        volatile bool* _pExtraLimited = nullptr;
+        // _extraAxis and _extraMotorNum let the limit control two motors,
+        // as with CoreXY
+        int _extraAxis     = -1;
+        int _extraMotorNum = -1;
 
         volatile uint32_t* _posLimits = nullptr;
         volatile uint32_t* _negLimits = nullptr;
 
+        void stopMotors(bool active);
+
     public:
         LimitPin(int axis, int motorNum, int direction, bool& phardLimits);
 
@@ -34,8 +40,5 @@ namespace Machine {
 
         bool isHard() { return _pHardLimits; }
         void init();
-
-        int _axis;
-        int _motorNum;
     };
 }
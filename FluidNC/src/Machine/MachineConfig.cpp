@@ -21,6 +21,7 @@
 #include "src/Configuration/Validator.h"
 #include "src/Configuration/AfterParse.h"
 #include "src/Configuration/ParseException.h"
+#include "src/Configuration/GCodeParamIndex.h"
 #include "src/Config.h"  // ENABLE_*
 
 #include "Driver/restart.h"
@@ -80,7 +81,7 @@ namespace Machine {
         handler.item("report_inches", _reportInches);
         handler.item("enable_parking_override_control", _enableParkingOverrideControl);
         handler.item("use_line_numbers", _useLineNumbers);
-        handler.item("planner_blocks", _planner_blocks, 10, 120);
+        handler.item("planner_blocks", _planner_blocks, 10, 1000);
     }
 
     void MachineConfig::afterParse() {
@@ -235,6 +236,9 @@ namespace Machine {
                 config->group(validator);
             } catch (std::exception& ex) { log_config_error("Validation error: " << ex.what()); }
 
+            // Index the numeric items so that #</path> parameters need not walk the tree
+            Configuration::GCodeParamIndex::build(config);
+
             // log_info("Heap size after configuation load is " << uint32_t(xPortGetFreeHeapSize()));
 
         } catch (const Configuration::ParseException& ex) {
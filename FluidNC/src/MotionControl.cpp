@@ -311,6 +311,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     // Setup and queue probing motion. Auto cycle-start should not start the cycle.
     mc_linear(target, pl_data, gc_state.position);
     // Activate the probing state monitor in the stepper module.
+    config->_probe->arm();
     probing = true;
     // Perform probing cycle. Wait here until probe is triggered or motion completes.
     protocol_send_event(&cycleStartEvent);
@@ -338,9 +339,12 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     probing = false;              // Ensure probe state monitor is disabled.
     protocol_execute_realtime();  // Check and execute run-time commands
     // Reset the stepper and planner buffers to remove the remainder of the probe motion.
-    Stepper::reset();      // Reset step segment buffer.
-    plan_reset();          // Reset planner buffer. Zero planner positions. Ensure probing motion is cleared.
-    plan_sync_position();  // Sync planner position to current machine position.
+    {
+        std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+        Stepper::reset();      // Reset step segment buffer.
+        plan_reset();          // Reset planner buffer. Zero planner positions. Ensure probing motion is cleared.
+        plan_sync_position();  // Sync planner position to current machine position.
+    }
     if (MESSAGE_PROBE_COORDINATES) {
         // All done! Output the probe position as message.
         report_probe_parameters(allChannels);
@@ -175,6 +175,23 @@ float limit_acceleration_by_axis_maximum(float* unit_vec) {
     return limit_value * secPerMinSq;
 }
 
+// Like limit_acceleration_by_axis_maximum(), except that an axis with no jerk limit
+// imposes none, and the result is 0 if no axis in the move has a limit.
+float limit_jerk_by_axis_maximum(float* unit_vec) {
+    float limit_value = SOME_LARGE_VALUE;
+    auto  n_axis      = Axes::_numberAxis;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        auto axisSetting = Axes::_axis[idx];
+        if (unit_vec[idx] != 0 && axisSetting->_jerk > 0) {
+            limit_value = MIN(limit_value, fabsf(axisSetting->_jerk / unit_vec[idx]));
+        }
+    }
+    if (limit_value == SOME_LARGE_VALUE) {
+        return 0.0f;
+    }
+    return limit_value * secPerMinSq * 60.0f;  // mm/sec^3 to mm/min^3
+}
+
 float limit_rate_by_axis_maximum(float* unit_vec) {
     float limit_value = SOME_LARGE_VALUE;
     auto  n_axis      = Axes::_numberAxis;
@@ -7,6 +7,7 @@
 #include "NutsBolts.h"
 #include "System.h"
 #include "Configuration/GCodeParam.h"
+#include "Configuration/GCodeParamIndex.h"
 #include "Machine/MachineConfig.h"
 #include "MotionControl.h"
 #include "GCode.h"
@@ -14,6 +15,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 
 #include "Expression.h"
 
@@ -71,38 +73,6 @@ const std::map<const ngc_param_id_t, CoordIndex> axis_params = {
     // { 5401, CoordIndex::TLO },
 };
 
-const std::map<const std::string, int> work_positions = {
-    { "_x", 0 },
-    { "_y", 1 },
-    { "_z", 2 },
-    { "_a", 3 },
-    { "_b", 4 },
-    { "_c", 5 },
-    //    { "_u", 0},
-    //    { "_v", 0},
-    //    { "_w", 0},
-};
-const std::map<const std::string, int> machine_positions = {
-    { "_abs_x", 0 },
-    { "_abs_y", 1 },
-    { "_abs_z", 2 },
-    { "_abs_a", 3 },
-    { "_abs_b", 4 },
-    { "_abs_c", 5 },
-    //    { "_abs_u", 0},
-    //    { "_abs_v", 0},
-    //    { "_abs_w", 0},
-};
-
-const std::array<const std::string, 6> unsupported_sys = {
-    "_spindle_rpm_mode",
-    "_spindle_css_mode",
-    "_ijk_absolute_mode",
-    "_lathe_diameter_mode",
-    "_lathe_radius_mode",
-    "_adaptive_feed",
-};
-
 // clang-format on
 
 std::map<std::string, float> global_named_params;
@@ -193,14 +163,16 @@ bool get_numbered_param(ngc_param_id_t id, float& result) {
     return false;
 }
 
-// TODO - make this a variant?
-struct param_ref_t {
-    std::string    name;  // If non-empty, the parameter is named
-    ngc_param_id_t id;    // Valid if name is empty
-};
 std::vector<std::tuple<param_ref_t, float>> assignments;
 
 bool set_config_item(const std::string& name, float result) {
+    if (auto item = Configuration::GCodeParamIndex::find(name)) {
+        if (item->set(result)) {
+            return true;
+        }
+        log_debug("Failed to set " << name);
+        return false;
+    }
     try {
         Configuration::GCodeParam gci(name.c_str(), result, false);
         config->group(gci);
@@ -216,6 +188,9 @@ bool set_config_item(const std::string& name, float result) {
 }
 
 bool get_config_item(const std::string& name, float& result) {
+    if (auto item = Configuration::GCodeParamIndex::find(name)) {
+        return item->get(result);
+    }
     try {
         Configuration::GCodeParam gci(name.c_str(), result, true);
         config->group(gci);
@@ -231,143 +206,173 @@ bool get_config_item(const std::string& name, float& result) {
 
 int coord_values[] = { 540, 550, 560, 570, 580, 590, 591, 592, 593 };
 
-bool get_system_param(const std::string& name, float& result) {
-    std::string sysn;
-    for (auto const& c : name) {
-        sysn += tolower(c);
-    }
-    if (auto search = work_positions.find(sysn); search != work_positions.end()) {
-        auto axis = search->second;
-        result    = to_inches(axis, get_mpos()[axis] - get_wco()[axis]);
-        return true;
-    }
-    if (auto search = machine_positions.find(sysn); search != machine_positions.end()) {
-        auto axis = search->second;
-        result    = to_inches(axis, get_mpos()[axis]);
-        return true;
-    }
-    if (std::find(unsupported_sys.begin(), unsupported_sys.end(), sysn) != unsupported_sys.end()) {
-        result = 0.0;
-        return true;
-    }
-    if (sysn == "_spindle_on") {
+template <int axis>
+static bool work_position(float& result) {
+    result = to_inches(axis, get_mpos()[axis] - get_wco()[axis]);
+    return true;
+}
+
+template <int axis>
+static bool machine_position(float& result) {
+    result = to_inches(axis, get_mpos()[axis]);
+    return true;
+}
+
+static bool unsupported_sys(float& result) {
+    result = 0.0;
+    return true;
+}
+
+// clang-format off
+static const std::unordered_map<std::string_view, system_param_t, string_util::hash_ignore_case, string_util::equal_to_ignore_case> system_params = {
+    { "_x", work_position<0> },
+    { "_y", work_position<1> },
+    { "_z", work_position<2> },
+    { "_a", work_position<3> },
+    { "_b", work_position<4> },
+    { "_c", work_position<5> },
+    //    { "_u", 0},
+    //    { "_v", 0},
+    //    { "_w", 0},
+    { "_abs_x", machine_position<0> },
+    { "_abs_y", machine_position<1> },
+    { "_abs_z", machine_position<2> },
+    { "_abs_a", machine_position<3> },
+    { "_abs_b", machine_position<4> },
+    { "_abs_c", machine_position<5> },
+    //    { "_abs_u", 0},
+    //    { "_abs_v", 0},
+    //    { "_abs_w", 0},
+    { "_spindle_rpm_mode", unsupported_sys },
+    { "_spindle_css_mode", unsupported_sys },
+    { "_ijk_absolute_mode", unsupported_sys },
+    { "_lathe_diameter_mode", unsupported_sys },
+    { "_lathe_radius_mode", unsupported_sys },
+    { "_adaptive_feed", unsupported_sys },
+
+    { "_spindle_on", [](float& result) {
         result = gc_state.modal.spindle != SpindleState::Disable;
         return true;
-    }
-    if (sysn == "_spindle_cw") {
+    } },
+    { "_spindle_cw", [](float& result) {
         result = gc_state.modal.spindle == SpindleState::Cw;
         return true;
-    }
-    if (sysn == "_spindle_m") {
+    } },
+    { "_spindle_m", [](float& result) {
         result = static_cast<int>(gc_state.modal.spindle);
         return true;
-    }
-
-    if (sysn == "_mist") {
+    } },
+    { "_mist", [](float& result) {
         result = gc_state.modal.coolant.Mist;
         return true;
-    }
-    if (sysn == "_flood") {
+    } },
+    { "_flood", [](float& result) {
         result = gc_state.modal.coolant.Flood;
         return true;
-    }
-    if (sysn == "_speed_override") {
+    } },
+    { "_speed_override", [](float& result) {
         result = sys.spindle_speed_ovr != 100;
         return true;
-    }
-    if (sysn == "_feed_override") {
+    } },
+    { "_feed_override", [](float& result) {
         result = sys.f_override != 100;
         return true;
-    }
-    if (sysn == "_feed_hold") {
+    } },
+    { "_feed_hold", [](float& result) {
         result = sys.state == State::Hold;
         return true;
-    }
-    if (sysn == "_feed") {
+    } },
+    { "_feed", [](float& result) {
         result = to_inches(0, gc_state.feed_rate);
         return true;
-    }
-    if (sysn == "_rpm") {
+    } },
+    { "_rpm", [](float& result) {
         result = gc_state.spindle_speed;
         return true;
-    }
-    if (sysn == "_selected_tool") {
+    } },
+    { "_selected_tool", [](float& result) {
         result = gc_state.selected_tool;
         return true;
-    }
-
-    if (sysn == "_current_tool") {
+    } },
+    { "_current_tool", [](float& result) {
         result = gc_state.current_tool;
         return true;
-    }
-
-    if (sysn == "_vmajor") {
+    } },
+    { "_vmajor", [](float& result) {
         std::string version(grbl_version);
         auto        major = version.substr(0, version.find('.'));
         result            = atoi(major.c_str());
         return true;
-    }
-    if (sysn == "_vminor") {
+    } },
+    { "_vminor", [](float& result) {
         std::string version(grbl_version);
         auto        minor = version.substr(version.find('.') + 1);
 
         result = atoi(minor.c_str());
         return true;
-    }
-    if (sysn == "_line") {
+    } },
+    { "_line", [](float& result) {
         //XXX Implement me
         return true;
-    }
-    if (sysn == "_motion_mode") {
+    } },
+    { "_motion_mode", [](float& result) {
         result = static_cast<gcodenum_t>(gc_state.modal.motion);
         return true;
-    }
-    if (sysn == "_plane") {
+    } },
+    { "_plane", [](float& result) {
         result = static_cast<gcodenum_t>(gc_state.modal.plane_select);
         return true;
-    }
+    } },
 #if 0
-    if (sysn == "_ccomp") {
+    { "_ccomp", [](float& result) {
         result = static_cast<gcodenum_t>(gc_state.modal.cutter_comp);
         return true;
-    }
+    } },
 #endif
-    if (sysn == "_coord_system") {
+    { "_coord_system", [](float& result) {
         result = coord_values[gc_state.modal.coord_select];
         return true;
-    }
-
-    if (sysn == "_metric") {
+    } },
+    { "_metric", [](float& result) {
         result = gc_state.modal.units == Units::Mm;
         return true;
-    }
-    if (sysn == "_imperial") {
+    } },
+    { "_imperial", [](float& result) {
         result = gc_state.modal.units == Units::Inches;
         return true;
-    }
-    if (sysn == "_absolute") {
+    } },
+    { "_absolute", [](float& result) {
         result = gc_state.modal.distance == Distance::Absolute;
         return true;
-    }
-    if (sysn == "_incremental") {
+    } },
+    { "_incremental", [](float& result) {
         result = gc_state.modal.distance == Distance::Incremental;
         return true;
-    }
-    if (sysn == "_inverse_time") {
+    } },
+    { "_inverse_time", [](float& result) {
         result = gc_state.modal.feed_rate == FeedRate::InverseTime;
         return true;
-    }
-    if (sysn == "_units_per_minute") {
+    } },
+    { "_units_per_minute", [](float& result) {
         result = gc_state.modal.feed_rate == FeedRate::UnitsPerMin;
         return true;
-    }
-    if (sysn == "_units_per_rev") {
+    } },
+    { "_units_per_rev", [](float& result) {
         // result = gc_state.modal.feed_rate == FeedRate::UnitsPerRev;
         result = 0.0;
         return true;
-    }
+    } },
+};
+// clang-format on
 
-    return false;
+static system_param_t find_system_param(std::string_view name) {
+    auto it = system_params.find(name);
+    return it == system_params.end() ? nullptr : it->second;
+}
+
+bool get_system_param(const std::string& name, float& result) {
+    auto param = find_system_param(name);
+    return param && param(result);
 }
 
 bool system_param_exists(const std::string& name) {
@@ -377,7 +382,7 @@ bool system_param_exists(const std::string& name) {
 
 // The LinuxCNC doc says that the EXISTS syntax is like EXISTS[#<_foo>]
 // For convenience, we also allow EXISTS[_foo]
-bool named_param_exists(std::string& name) {
+bool named_param_exists(const std::string& name) {
     std::string search;
     if (name.length() > 3 && name[0] == '#' && name[1] == '<' && name.back() == '>') {
         search = name.substr(2, name.length() - 3);
@@ -413,8 +418,27 @@ bool get_global_named_param(const std::string& name, float& value) {
     return true;
 }
 
+// Looks up a config item or system parameter when its name is parsed, so that
+// reading or writing it later needs no lookup
+void resolve_param(param_ref_t& param_ref) {
+    const auto& name = param_ref.name;
+    if (name.length()) {
+        if (name[0] == '/') {
+            param_ref.config_item = Configuration::GCodeParamIndex::find(name);
+        } else if (name[0] == '_') {
+            param_ref.system_param = find_system_param(name);
+        }
+    }
+}
+
 bool get_param(const param_ref_t& param_ref, float& value) {
-    auto name = param_ref.name;
+    if (param_ref.config_item) {
+        return param_ref.config_item->get(value);
+    }
+    if (param_ref.system_param) {
+        return param_ref.system_param(value);
+    }
+    const auto& name = param_ref.name;
     if (name.length()) {
         if (name[0] == '/') {
             return get_config_item(name, value);
@@ -464,6 +488,7 @@ bool get_param_ref(const char* line, size_t& pos, param_ref_t& param_ref) {
                 return false;
             }
             ++pos;
+            resolve_param(param_ref);
             return true;
         case '[': {
             // Expression evaluating to param number
@@ -526,13 +551,20 @@ bool set_numbered_param(ngc_param_id_t id, float value) {
 bool set_param(const param_ref_t& param_ref, float value) {
     if (param_ref.name.length()) {  // Named parameter
         auto name = param_ref.name;
+        if (param_ref.config_item) {
+            if (param_ref.config_item->set(value)) {
+                return true;
+            }
+            log_debug("Failed to set " << name);
+            return false;
+        }
         if (name[0] == '/') {
             return set_config_item(param_ref.name, value);
         }
         if (name[0] != '_' && Job::active()) {
             return Job::set_param(name, value);
         }
-        if (name[0] == '_' && system_param_exists(name)) {
+        if (param_ref.system_param || (name[0] == '_' && system_param_exists(name))) {
             log_debug("Attempt to set read-only parameter " << name);
             return false;
         }
@@ -547,7 +579,7 @@ bool set_param(const param_ref_t& param_ref, float value) {
 }
 
 // Gets a numeric value, either a literal number or a #-prefixed parameter value
-bool read_number(const char* line, size_t& pos, float& result, bool in_expression) {
+bool read_number(const char* line, size_t& pos, float& result) {
     char c = line[pos];
     if (c == '#') {
         ++pos;
@@ -569,25 +601,6 @@ bool read_number(const char* line, size_t& pos, float& result, bool in_expressio
         }
         return true;
     }
-    if (in_expression) {
-        if (isalpha(c)) {
-            // Functions are available only inside expressions because
-            // their names conflict with GCode words
-            return read_unary(line, pos, result) == Error::Ok;
-        }
-        if (c == '-') {
-            ++pos;
-            if (!read_number(line, pos, result, in_expression)) {
-                return false;
-            }
-            result = -result;
-            return true;
-        }
-        if (c == '+') {
-            ++pos;
-            return read_number(line, pos, result, in_expression);
-        }
-    }
     return read_float(line, pos, result);
 }
 
@@ -10,9 +10,27 @@
 // possible
 typedef int ngc_param_id_t;
 
+namespace Configuration {
+    class GCodeParamItem;
+}
+
+typedef bool (*system_param_t)(float& value);
+
+// TODO - make this a variant?
+struct param_ref_t {
+    std::string    name;  // If non-empty, the parameter is named
+    ngc_param_id_t id;    // Valid if name is empty
+
+    // Set by resolve_param() if the name is a config item or a system parameter
+    const Configuration::GCodeParamItem* config_item  = nullptr;
+    system_param_t                       system_param = nullptr;
+};
+
 bool assign_param(const char* line, size_t& pos);
-bool read_number(const char* line, size_t& pos, float& value, bool in_expression = false);
+bool read_number(const char* line, size_t& pos, float& value);
 bool perform_assignments();
-bool named_param_exists(std::string& name);
+bool get_param(const param_ref_t& param_ref, float& value);
+void resolve_param(param_ref_t& param_ref);
+bool named_param_exists(const std::string& name);
 bool set_named_param(const char* name, float value);
 bool set_numbered_param(ngc_param_id_t, float value);
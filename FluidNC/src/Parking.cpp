@@ -13,6 +13,8 @@ void Parking::moveto(float* target) {
     if (sys.abort) {
         return;  // Block during abort.
     }
+    // Parking drives the segment buffer directly, so keep the prep task out until it is done
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     if (plan_buffer_line(target, &plan_data)) {
         sys.step_control.executeSysMotion = true;
         sys.step_control.endMotion        = false;  // Allow parking motion to execute, if feed hold is active.
@@ -17,8 +17,15 @@
 #include <string_view>
 #include <charconv>
 
-Pins::PinDetail* Pin::undefinedPin = new Pins::VoidPinDetail();
-Pins::PinDetail* Pin::errorPin     = new Pins::ErrorPinDetail("unknown");
+// These are statically allocated so that the pointers are constant-initialized.
+// Pin objects with static storage, like Axes::_sharedStepperDisable, copy
+// undefinedPin in their constructors, which can run before this file's
+// dynamic initializers depending on the link order.
+static Pins::VoidPinDetail  undefinedPinDetail;
+static Pins::ErrorPinDetail errorPinDetail("unknown");
+
+Pins::PinDetail* Pin::undefinedPin = &undefinedPinDetail;
+Pins::PinDetail* Pin::errorPin     = &errorPinDetail;
 
 static constexpr bool verbose_debugging = false;
 
@@ -132,7 +139,7 @@ bool Pin::validate(const char* str) {
     Pins::PinDetail* pinImplementation;
 
     auto valid = parse(str, pinImplementation);
-    if (pinImplementation) {
+    if (pinImplementation && pinImplementation != undefinedPin) {
         delete pinImplementation;
     }
 
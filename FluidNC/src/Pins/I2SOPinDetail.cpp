@@ -1,7 +1,7 @@
 // Copyright (c) 2021 -  Stefan de Bruijn
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
-#ifdef ESP32
+#if defined(ESP32) || defined(SIMULATOR)
 #    include "I2SOPinDetail.h"
 
 #    include "Driver/i2s_out.h"  // i2s_out_write() etc
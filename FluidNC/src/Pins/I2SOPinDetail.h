@@ -2,7 +2,7 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #pragma once
-#ifdef ESP32
+#if defined(ESP32) || defined(SIMULATOR)
 
 #    include "PinDetail.h"
 
@@ -10,21 +10,64 @@
 
 #include "Planner.h"
 #include "Machine/MachineConfig.h"
+#include "Driver/benchmark.h"
+#include "SCurve.h"
+#include "Raster.h"  // Raster::reset()
 
 #include <cstdlib>  // PSoc Required for labs
 #include <cmath>
+#include <sdkconfig.h>  // CONFIG_SPIRAM*
+
+#if defined(CONFIG_SPIRAM) || defined(CONFIG_SPIRAM_SUPPORT)
+#    include <esp_heap_caps.h>
+#endif
 
 static plan_block_t* block_buffer = nullptr;  // A ring buffer for motion instructions
-static uint8_t       block_buffer_tail;       // Index of the block to process now
-static uint8_t       block_buffer_head;       // Index of the next block to be pushed
-static uint8_t       next_buffer_head;        // Index of the next buffer head
-static uint8_t       block_buffer_planned;    // Index of the optimally planned block
+static uint32_t*     block_steps  = nullptr;  // Step counts of the blocks, Axes::_numberAxis per block
+static uint16_t      block_buffer_tail;       // Index of the block to process now
+static uint16_t      block_buffer_head;       // Index of the next block to be pushed
+static uint16_t      next_buffer_head;        // Index of the next buffer head
+static uint16_t      block_buffer_planned;    // Index of the optimally planned block
+
+// Buffers up to this many blocks stay in internal RAM, which is faster to plan over
+static const uint32_t INTERNAL_RAM_BLOCKS = 120;
 
 void plan_init() {
-    if (block_buffer) {
-        delete[] block_buffer;
+    free(block_buffer);
+    free(block_steps);
+    block_buffer = nullptr;
+    block_steps  = nullptr;
+
+    // The step counts are sized by the configured axes rather than MAX_N_AXIS
+    size_t steps_per_block = Axes::_numberAxis * sizeof(uint32_t);
+    size_t blocks          = config->_planner_blocks;
+#if defined(CONFIG_SPIRAM) || defined(CONFIG_SPIRAM_SUPPORT)
+    // A deep look-ahead buffer goes in PSRAM on boards that have it.  The planner and the
+    // segment generator run as tasks, so the buffer is never touched from an ISR.
+    if (blocks > INTERNAL_RAM_BLOCKS) {
+        block_buffer = static_cast<plan_block_t*>(heap_caps_malloc(blocks * sizeof(plan_block_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        block_steps  = static_cast<uint32_t*>(heap_caps_malloc(blocks * steps_per_block, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    }
+#endif
+    if (!block_buffer) {
+        block_buffer = static_cast<plan_block_t*>(malloc(blocks * sizeof(plan_block_t)));
+    }
+    if (!block_steps) {
+        block_steps = static_cast<uint32_t*>(malloc(blocks * steps_per_block));
+    }
+    if ((!block_buffer || !block_steps) && blocks > INTERNAL_RAM_BLOCKS) {
+        log_error("Not enough memory for " << blocks << " planner blocks, using " << INTERNAL_RAM_BLOCKS);
+        free(block_buffer);
+        free(block_steps);
+        blocks                  = INTERNAL_RAM_BLOCKS;
+        config->_planner_blocks = blocks;
+        block_buffer            = static_cast<plan_block_t*>(malloc(blocks * sizeof(plan_block_t)));
+        block_steps             = static_cast<uint32_t*>(malloc(blocks * steps_per_block));
+    }
+    if (!block_buffer || !block_steps) {
+        // The config alarm keeps motion, and with it the planner, from ever running
+        log_config_error("Not enough memory for " << blocks << " planner blocks");
     }
-    block_buffer = new plan_block_t[config->_planner_blocks];
 }
 
 // Define planner variables
@@ -33,12 +76,27 @@ typedef struct {
     // from g-code position for movements requiring multiple line motions,
     // i.e. arcs, canned cycles, and backlash compensation.
     float previous_unit_vec[MAX_N_AXIS];  // Unit vector of previous path line segment
-    float previous_nominal_speed;         // Nominal speed of previous path line segment
 } planner_t;
 static planner_t pl;
 
+// Continuous mode (G64) state.  The newest block stays open for changes until the step generator
+// starts on it, so that the next line can be merged into it or joined to it by a blended corner.
+// Changing it means taking it back out of the buffer and re-adding it in its new form.
+static const int MAX_MERGED_POINTS = 8;  // Corner points that one merged block may skip
+
+static struct {
+    bool             open;                                   // The newest block may be replaced
+    planner_t        pl;                                     // Planner state from before the newest block
+    uint16_t         planned;                                // block_buffer_planned from before the newest block
+    plan_line_data_t pl_data;                                // Line data of the newest block
+    float            start[MAX_N_AXIS];                      // Start of the newest block in mm
+    float            end[MAX_N_AXIS];                        // End of the newest block in mm
+    float            points[MAX_MERGED_POINTS][MAX_N_AXIS];  // Corner points merged into the newest block
+    int              n_points;                               // Number of merged corner points
+} newest;
+
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
-static uint8_t plan_next_block_index(uint8_t block_index) {
+static uint16_t plan_next_block_index(uint16_t block_index) {
     block_index++;
     if (block_index == config->_planner_blocks) {
         block_index = 0;
@@ -47,7 +105,7 @@ static uint8_t plan_next_block_index(uint8_t block_index) {
 }
 
 // Returns the index of the previous block in the ring buffer
-static uint8_t plan_prev_block_index(uint8_t block_index) {
+static uint16_t plan_prev_block_index(uint16_t block_index) {
     if (block_index == 0) {
         block_index = config->_planner_blocks;
     }
@@ -119,14 +177,56 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   to compute an optimal plan, so select carefully. The Arduino 328p memory is already maxed out, but future
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
+  For a block with a jerk limit, the maximum allowable acceleration or deceleration in 1b and 2a is an
+  S-curve ramp instead, whose speed change over a distance comes from scurve_reach_speed().
+
 */
+
+// Highest speed squared that the block can reach from speed_sqr over its length, which is also the highest
+// from which it can decelerate to speed_sqr.
+static float plan_reach_speed_sqr(const plan_block_t* block, float speed_sqr) {
+    if (block->jerk > 0.0f) {
+        float speed = scurve_reach_speed(sqrtf(speed_sqr), block->millimeters, block->acceleration, block->jerk);
+        return speed * speed;
+    }
+    return speed_sqr + 2 * block->acceleration * block->millimeters;
+}
+
+// Nominal speeds depend on the overrides. Each block caches its own, tagged with the override generation
+// it was computed for, so that planner_recalculate() does not recompute them for every block it visits.
+// An override change only bumps the generation; the replan that follows it recomputes them as it goes.
+static uint32_t override_generation = 0;
+
+static float plan_nominal_speed(plan_block_t* block) {
+    if (block->nominal_generation != override_generation) {
+        block->nominal_speed      = plan_compute_profile_nominal_speed(block);
+        block->nominal_generation = override_generation;
+    }
+    return block->nominal_speed;
+}
+
+// Maximum entry speed squared of a block, the lowest of its junction limit and the nominal speeds on both
+// sides of the junction. Only called for blocks after the planned pointer, so the previous block is still
+// in the buffer.
+static float plan_max_entry_speed_sqr(uint16_t block_index) {
+    plan_block_t* block         = &block_buffer[block_index];
+    float         nominal_speed = plan_nominal_speed(block);
+    float         prev_speed    = plan_nominal_speed(&block_buffer[plan_prev_block_index(block_index)]);
+    if (prev_speed < nominal_speed) {
+        nominal_speed = prev_speed;
+    }
+    return MIN(nominal_speed * nominal_speed, block->max_junction_speed_sqr);
+}
+
 static void planner_recalculate() {
+    BENCH_PROBE(PlannerRecalculate);
+    BENCH_ITEMS(1);
     if (block_buffer_head == block_buffer_tail) {
         // Nothing to do; planner buffer is empty.
         return;
     }
     // Initialize block index to the last block in the planner buffer.
-    uint8_t block_index = plan_prev_block_index(block_buffer_head);
+    uint16_t block_index = plan_prev_block_index(block_buffer_head);
     // Bail. Can't do anything with one only one plan-able block.
     if (block_index == block_buffer_planned) {
         return;
@@ -135,10 +235,11 @@ static void planner_recalculate() {
     // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
     // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
     float         entry_speed_sqr;
+    float         max_entry_speed_sqr;
     plan_block_t* next;
     plan_block_t* current = &block_buffer[block_index];
     // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
-    current->entry_speed_sqr = MIN(current->max_entry_speed_sqr, 2 * current->acceleration * current->millimeters);
+    current->entry_speed_sqr = MIN(plan_max_entry_speed_sqr(block_index), plan_reach_speed_sqr(current, 0.0f));
     block_index              = plan_prev_block_index(block_index);
     if (block_index == block_buffer_planned) {  // Only two plannable blocks in buffer. Reverse pass complete.
         // Check if the first block is the tail. If so, notify stepper to update its current parameters.
@@ -147,20 +248,21 @@ static void planner_recalculate() {
         }
     } else {  // Three or more plan-able blocks
         while (block_index != block_buffer_planned) {
-            next        = current;
-            current     = &block_buffer[block_index];
-            block_index = plan_prev_block_index(block_index);
+            next                = current;
+            current             = &block_buffer[block_index];
+            max_entry_speed_sqr = plan_max_entry_speed_sqr(block_index);
+            block_index         = plan_prev_block_index(block_index);
             // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
             if (block_index == block_buffer_tail) {
                 Stepper::update_plan_block_parameters();
             }
             // Compute maximum entry speed decelerating over the current block from its exit speed.
-            if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
-                entry_speed_sqr = next->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
-                if (entry_speed_sqr < current->max_entry_speed_sqr) {
+            if (current->entry_speed_sqr != max_entry_speed_sqr) {
+                entry_speed_sqr = plan_reach_speed_sqr(current, next->entry_speed_sqr);
+                if (entry_speed_sqr < max_entry_speed_sqr) {
                     current->entry_speed_sqr = entry_speed_sqr;
                 } else {
-                    current->entry_speed_sqr = current->max_entry_speed_sqr;
+                    current->entry_speed_sqr = max_entry_speed_sqr;
                 }
             }
         }
@@ -176,10 +278,10 @@ static void planner_recalculate() {
         // pointer forward, since everything before this is all optimal. In other words, nothing
         // can improve the plan from the buffer tail to the planned pointer by logic.
         if (current->entry_speed_sqr < next->entry_speed_sqr) {
-            entry_speed_sqr = current->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
+            entry_speed_sqr = plan_reach_speed_sqr(current, current->entry_speed_sqr);
             // If true, current block is full-acceleration and we can move the planned pointer forward.
             if (entry_speed_sqr < next->entry_speed_sqr) {
-                next->entry_speed_sqr = entry_speed_sqr;  // Always <= max_entry_speed_sqr. Backward pass sets this.
+                next->entry_speed_sqr = entry_speed_sqr;  // Always <= max entry speed. Backward pass sets this.
                 block_buffer_planned  = block_index;      // Set optimal plan pointer.
             }
         }
@@ -187,7 +289,7 @@ static void planner_recalculate() {
         // point in the buffer. When the plan is bracketed by either the beginning of the
         // buffer and a maximum entry speed or two maximum entry speeds, every block in between
         // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-        if (next->entry_speed_sqr == next->max_entry_speed_sqr) {
+        if (next->entry_speed_sqr == plan_max_entry_speed_sqr(block_index)) {
             block_buffer_planned = block_index;
         }
         block_index = plan_next_block_index(block_index);
@@ -195,21 +297,24 @@ static void planner_recalculate() {
 }
 
 void plan_reset() {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     memset(&pl, 0, sizeof(planner_t));  // Clear planner struct
     plan_reset_buffer();
 }
 
 void plan_reset_buffer() {
+    Raster::reset();  // No block refers to the scanline pixels any more
     block_buffer_tail    = 0;
     block_buffer_head    = 0;  // Empty = tail
     next_buffer_head     = 1;  // plan_next_block_index(block_buffer_head)
     block_buffer_planned = 0;  // = block_buffer_tail;
+    newest.open          = false;
 }
 
 // Called from stepper pulse function when the block is complete
 void plan_discard_current_block() {
     if (block_buffer_head != block_buffer_tail) {  // Discard non-empty buffer.
-        uint8_t block_index = plan_next_block_index(block_buffer_tail);
+        uint16_t block_index = plan_next_block_index(block_buffer_tail);
         // Push block_buffer_planned pointer, if encountered.
         if (block_buffer_tail == block_buffer_planned) {
             block_buffer_planned = block_index;
@@ -231,8 +336,19 @@ plan_block_t* plan_get_current_block() {
     return &block_buffer[block_buffer_tail];
 }
 
+plan_block_t* plan_get_block(uint16_t offset) {
+    uint16_t block_index = block_buffer_tail;
+    for (; offset && block_index != block_buffer_head; --offset) {
+        block_index = plan_next_block_index(block_index);
+    }
+    if (block_index == block_buffer_head) {
+        return NULL;
+    }
+    return &block_buffer[block_index];
+}
+
 float plan_get_exec_block_exit_speed_sqr() {
-    uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    uint16_t block_index = plan_next_block_index(block_buffer_tail);
     if (block_index == block_buffer_head) {
         return 0.0f;
     }
@@ -264,50 +380,34 @@ float plan_compute_profile_nominal_speed(plan_block_t* block) {
     return MINIMUM_FEED_RATE;
 }
 
-// Computes and updates the max entry speed (sqr) of the block, based on the minimum of the junction's
-// previous and current nominal speeds and max junction speed.
-static void plan_compute_profile_parameters(plan_block_t* block, float nominal_speed, float prev_nominal_speed) {
-    // Compute the junction maximum entry based on the minimum of the junction speed and neighboring nominal speeds.
-    if (nominal_speed > prev_nominal_speed) {
-        block->max_entry_speed_sqr = prev_nominal_speed * prev_nominal_speed;
-    } else {
-        block->max_entry_speed_sqr = nominal_speed * nominal_speed;
-    }
-
-    if (block->max_entry_speed_sqr > block->max_junction_speed_sqr) {
-        block->max_entry_speed_sqr = block->max_junction_speed_sqr;
-    }
-}
-
-// Re-calculates buffered motions profile parameters upon a motion-based override change.
+// Re-plans buffered motions upon a motion-based override change.  Unlike adding a block, this is not
+// incremental: the override scales the nominal speed of every block, so a lower one can force entry speeds
+// down anywhere in the buffer and a higher one can let them rise anywhere.  The whole buffer is replanned
+// from the tail, once per override change; bumping the generation makes that pass recompute the nominal
+// speed of each block once.
 void plan_update_velocity_profile_parameters() {
-    uint8_t       block_index = block_buffer_tail;
-    plan_block_t* block;
-    float         nominal_speed;
-    float         prev_nominal_speed = SOME_LARGE_VALUE;  // Set high for first block nominal speed calculation.
-    while (block_index != block_buffer_head) {
-        block         = &block_buffer[block_index];
-        nominal_speed = plan_compute_profile_nominal_speed(block);
-        plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
-        prev_nominal_speed = nominal_speed;
-        block_index        = plan_next_block_index(block_index);
-    }
-    pl.previous_nominal_speed = prev_nominal_speed;  // Update prev nominal speed for next incoming block.
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+    override_generation++;
     if (block_buffer_tail != block_buffer_head) {
         plan_cycle_reinitialize();
     }
 }
 
-bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+static bool plan_buffer_block(float* target, plan_line_data_t* pl_data) {
+    BENCH_PROBE(PlanBufferLine);
+    BENCH_ITEMS(1);
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
     plan_block_t* block = &block_buffer[block_buffer_head];
     memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
+    block->steps         = &block_steps[block_buffer_head * Axes::_numberAxis];
     block->motion        = pl_data->motion;
     block->coolant       = pl_data->coolant;
     block->spindle       = pl_data->spindle;
     block->spindle_speed = pl_data->spindle_speed;
     block->line_number   = pl_data->line_number;
     block->is_jog        = pl_data->is_jog;
+    block->raster_first  = pl_data->raster_first;
+    block->raster_pixels = pl_data->raster_pixels;
 
     // Compute and store initial move distance data.
     int32_t target_steps[MAX_N_AXIS], position_steps[MAX_N_AXIS];
@@ -350,6 +450,9 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     block->millimeters  = convert_delta_vector_to_unit_vector(unit_vec);
     block->acceleration = limit_acceleration_by_axis_maximum(unit_vec);
     block->rapid_rate   = limit_rate_by_axis_maximum(unit_vec);
+#ifndef PREP_FIXED_POINT
+    block->jerk = limit_jerk_by_axis_maximum(unit_vec);  // The fixed-point segment generator has only trapezoid ramps
+#endif
     // Store programmed rate.
     if (block->motion.rapidMotion) {
         block->programmed_rate = block->rapid_rate;
@@ -378,10 +481,9 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         //
         // NOTE: If the junction deviation value is finite, the motions are executed in exact path
         // mode (G61). If the junction deviation value is zero, the motions are executed in exact
-        // stop mode (G61.1) manner. In the future, if continuous mode (G64) is desired, the math here
-        // is exactly the same. Instead of motioning all the way to junction point, the machine will
-        // just follow the arc circle defined here. The Arduino doesn't have the CPU cycles to perform
-        // a continuous mode path, but ARM-based microcontrollers most certainly do.
+        // stop mode (G61.1) manner. In continuous mode (G64), plan_blend_corner() replaces the corner
+        // with an actual arc within the path tolerance before the blocks get here, so the junctions
+        // seen here are the shallow ones between its chords.
         //
         // NOTE: The max junction speed is a fixed value, since machine acceleration limits cannot be
         // changed dynamically during operation nor can the line move geometry. This must be kept in
@@ -413,9 +515,18 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     }
     // Block system motion from updating this data to ensure next g-code motion is computed correctly.
     if (!(block->motion.systemMotion)) {
-        float nominal_speed = plan_compute_profile_nominal_speed(block);
-        plan_compute_profile_parameters(block, nominal_speed, pl.previous_nominal_speed);
-        pl.previous_nominal_speed = nominal_speed;
+        block->nominal_speed      = plan_compute_profile_nominal_speed(block);
+        block->nominal_generation = override_generation;
+
+        // Remember how to take the block back out, in case the next line is merged or blended with it.
+        newest.pl      = pl;
+        newest.planned = block_buffer_planned;
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            newest.start[idx] = steps_to_mpos(position_steps[idx], idx);
+        }
+        copyAxes(newest.end, target);
+        newest.pl_data = *pl_data;
+
         // Update previous path unit_vector and planner position.
         copyAxes(pl.previous_unit_vec, unit_vec);
         copyAxes(pl.position, target_steps);
@@ -428,6 +539,222 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     return true;
 }
 
+// True if the newest block is in the buffer and the step generator has not started on it
+static bool plan_newest_block_open() {
+    return newest.open && block_buffer_head != block_buffer_tail && plan_prev_block_index(block_buffer_head) != block_buffer_tail;
+}
+
+// Takes the newest block back out of the buffer and restores the planner state from before it
+static void plan_remove_newest_block() {
+    block_buffer_head = plan_prev_block_index(block_buffer_head);
+    next_buffer_head  = plan_next_block_index(block_buffer_head);
+    // The plan up to the planned pointer from before the block was added did not depend on it, so it
+    // still holds unless the step generator has since moved past that pointer.  The blocks after it
+    // were planned to decelerate over the removed block, and the blocks that replace it may be shorter,
+    // so clear their entry speeds for the reverse pass to recompute, even those that were at their maximum.
+    uint16_t n_blocks = config->_planner_blocks;
+    uint16_t removed  = (block_buffer_head + n_blocks - block_buffer_tail) % n_blocks;
+    uint16_t planned  = (newest.planned + n_blocks - block_buffer_tail) % n_blocks;
+    block_buffer_planned = planned < removed ? newest.planned : block_buffer_tail;
+    uint16_t block_index = plan_next_block_index(block_buffer_planned);
+    while (block_index != block_buffer_head) {
+        block_buffer[block_index].entry_speed_sqr = 0.0f;
+        block_index                               = plan_next_block_index(block_index);
+    }
+    if (block_buffer_planned == block_buffer_tail) {
+        // Have the step generator pick up the new exit speed of the executing block
+        Stepper::update_plan_block_parameters();
+    }
+    pl = newest.pl;
+}
+
+// True if a line with these conditions can be merged or blended with the newest block
+static bool plan_same_conditions(const plan_line_data_t* a, const plan_line_data_t* b) {
+    return a->feed_rate == b->feed_rate && a->spindle_speed == b->spindle_speed && a->motion.rapidMotion == b->motion.rapidMotion &&
+           a->motion.noFeedOverride == b->motion.noFeedOverride && a->spindle == b->spindle && a->coolant.Mist == b->coolant.Mist &&
+           a->coolant.Flood == b->coolant.Flood && a->path_tolerance == b->path_tolerance && a->merge_tolerance == b->merge_tolerance;
+}
+
+// Distance from point p to the line segment from a to b, or a large value if p does not
+// lie alongside the segment
+static float plan_distance_to_segment(const float* p, const float* a, const float* b) {
+    auto  n_axis = Axes::_numberAxis;
+    float ab_ab = 0.0f, ap_ab = 0.0f, ap_ap = 0.0f;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        float ab = b[idx] - a[idx];
+        float ap = p[idx] - a[idx];
+        ab_ab += ab * ab;
+        ap_ab += ap * ab;
+        ap_ap += ap * ap;
+    }
+    if (ab_ab == 0.0f || ap_ab < 0.0f || ap_ab > ab_ab) {
+        return SOME_LARGE_VALUE;
+    }
+    return sqrtf(MAX(0.0f, ap_ap - ap_ab * ap_ab / ab_ab));
+}
+
+// Replaces the newest block and the new line by a single block from the start of the newest block to
+// the target, if the end of the newest block and the corners already merged into it all lie within the
+// merge tolerance of that block.  Long runs of short, nearly collinear CAM segments thus become a few
+// long blocks, giving the planner more distance to accelerate over.
+static bool plan_merge_line(float* target, plan_line_data_t* pl_data) {
+    float tolerance = pl_data->merge_tolerance;
+    if (tolerance <= 0.0f || newest.n_points == MAX_MERGED_POINTS) {
+        return false;
+    }
+    if (plan_distance_to_segment(newest.end, newest.start, target) > tolerance) {
+        return false;
+    }
+    for (int i = 0; i < newest.n_points; i++) {
+        if (plan_distance_to_segment(newest.points[i], newest.start, target) > tolerance) {
+            return false;
+        }
+    }
+    copyAxes(newest.points[newest.n_points], newest.end);
+    plan_remove_newest_block();
+    if (plan_buffer_block(target, pl_data)) {
+        // The newest block is the merged one, so it has the corner points of the old one plus its end.
+        newest.n_points++;
+    } else {
+        // The merged line came out shorter than a step, so nothing is left to merge into.
+        newest.open = false;
+        planner_recalculate();
+    }
+    return true;
+}
+
+// Joins the newest block to the new line with an arc that cuts the corner between them, staying within
+// the path tolerance.  The arc is split into chords like a G2/G3 arc, and each chord meets its neighbours
+// at a shallow angle, so the corner is taken at a speed limited by the radius of the arc instead of by
+// the junction deviation.
+static bool plan_blend_corner(float* target, plan_line_data_t* pl_data) {
+    float tolerance = pl_data->path_tolerance;
+    if (tolerance <= 0.0f) {
+        return false;
+    }
+
+    auto  n_axis = Axes::_numberAxis;
+    float u1[MAX_N_AXIS], u2[MAX_N_AXIS];
+    float cos_phi = 0.0f;  // Cosine of the turn angle at the corner
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        u1[idx] = newest.end[idx] - newest.start[idx];
+        u2[idx] = target[idx] - newest.end[idx];
+    }
+    float length1 = convert_delta_vector_to_unit_vector(u1);
+    float length2 = convert_delta_vector_to_unit_vector(u2);
+    if (length1 == 0.0f || length2 == 0.0f) {
+        return false;
+    }
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        cos_phi += u1[idx] * u2[idx];
+    }
+    if (cos_phi > 0.999999f) {
+        return false;  // Straight on, as the junction speed computation also treats it
+    }
+    float cos_half = sqrtf(0.5f * (1.0f + cos_phi));  // Trig half angle identities
+    float sin_half = sqrtf(0.5f * (1.0f - cos_phi));
+    if (cos_half < 0.1f) {
+        return false;  // A near reversal leaves no room for an arc
+    }
+
+    // The arc deviates from the corner by radius * bulge.  The planner takes a sharp corner at the speed for
+    // an arc of radius junction_deviation / bulge, so blending only pays off with a larger arc, and only if
+    // that speed is below the programmed rate.
+    float         tan_half        = sin_half / cos_half;
+    float         phi             = 2.0f * atan2f(sin_half, cos_half);
+    float         bulge           = 1.0f / cos_half - 1.0f;
+    float         junction_radius = config->_junctionDeviation / bulge;
+    plan_block_t* block           = &block_buffer[plan_prev_block_index(block_buffer_head)];
+    float         acceleration    = MIN(block->acceleration, limit_acceleration_by_axis_maximum(u2));
+    if (acceleration * junction_radius >= block->programmed_rate * block->programmed_rate) {
+        return false;
+    }
+
+    // The blocks on both sides of the corner may be cut back by at most half their length, leaving the other
+    // half for a blend at their other end.
+    float radius = MIN(tolerance / bulge, 0.5f * MIN(length1, length2) / tan_half);
+
+    // Split the arc into chords as mc_arc() does, limited by the free space in the planner buffer.
+    // The chords add their own sagitta to the deviation, so shrink the radius to keep the total
+    // within tolerance.
+    int max_chords = int(plan_get_block_buffer_available()) - 1;
+    if (max_chords < 1) {
+        return false;
+    }
+    float arc_tolerance = config->_arcTolerance;
+    int   chords        = 1;
+    if (2.0f * radius > arc_tolerance) {
+        chords = MAX(1, int(floorf(0.5f * phi * radius / sqrtf(arc_tolerance * (2.0f * radius - arc_tolerance)))));
+    }
+    chords = MIN(chords, max_chords);
+    radius = MIN(radius, tolerance / (bulge + 1.0f - cosf(0.5f * phi / chords)));
+    if (radius <= junction_radius) {
+        return false;
+    }
+
+    float setback = radius * tan_half;
+    float arc_start[MAX_N_AXIS], arc_end[MAX_N_AXIS], center[MAX_N_AXIS];
+    float bisector[MAX_N_AXIS];
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        arc_start[idx] = newest.end[idx] - setback * u1[idx];
+        arc_end[idx]   = newest.end[idx] + setback * u2[idx];
+        bisector[idx]  = u2[idx] - u1[idx];
+    }
+    convert_delta_vector_to_unit_vector(bisector);
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        center[idx] = newest.end[idx] + (radius / cos_half) * bisector[idx];
+    }
+
+    // Shorten the newest block to end where the arc starts, add the chords, and start the new line where
+    // the arc ends.  Any of these may come out shorter than a step, and are then dropped by the planner.
+    plan_line_data_t corner_data = newest.pl_data;
+    plan_remove_newest_block();
+    bool added = plan_buffer_block(arc_start, &corner_data);
+    float sin_phi = sinf(phi);
+    for (int i = 1; i < chords; i++) {
+        float point[MAX_N_AXIS];
+        float t  = float(i) / chords;
+        float wa = sinf((1.0f - t) * phi) / sin_phi;
+        float wb = sinf(t * phi) / sin_phi;
+        for (size_t idx = 0; idx < n_axis; idx++) {
+            point[idx] = center[idx] + wa * (arc_start[idx] - center[idx]) + wb * (arc_end[idx] - center[idx]);
+        }
+        added |= plan_buffer_block(point, pl_data);
+    }
+    added |= plan_buffer_block(arc_end, pl_data);
+    added |= plan_buffer_block(target, pl_data);
+    // Whichever block was added last is the newest one now.
+    newest.open = added;
+    if (!added) {
+        planner_recalculate();
+    }
+    return true;
+}
+
+bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+    if (pl_data->motion.systemMotion) {
+        return plan_buffer_block(target, pl_data);
+    }
+    // Inverse time feed rates are per line, so those lines are never changed.
+    bool continuous = !pl_data->is_jog && !pl_data->motion.inverseTime && (pl_data->path_tolerance > 0.0f || pl_data->merge_tolerance > 0.0f);
+    if (continuous && plan_newest_block_open() && plan_same_conditions(pl_data, &newest.pl_data)) {
+        if (plan_merge_line(target, pl_data)) {
+            return true;
+        }
+        if (plan_blend_corner(target, pl_data)) {
+            newest.n_points = 0;
+            return true;
+        }
+    }
+    bool added = plan_buffer_block(target, pl_data);
+    if (added) {
+        newest.open     = continuous;
+        newest.n_points = 0;
+    }
+    return added;
+}
+
 // Reset the planner position vectors. Called by the system abort/initialization routine.
 void plan_sync_position() {
     // TODO: For motor configurations not in the same coordinate frame as the machine position,
@@ -435,11 +762,12 @@ void plan_sync_position() {
     if (config->_axes) {
         get_motor_steps(pl.position);
     }
+    newest.open = false;
 }
 
 // Returns the number of available blocks are in the planner buffer.
 // Called from report_realtime_status
-uint8_t plan_get_block_buffer_available() {
+uint16_t plan_get_block_buffer_available() {
     if (block_buffer_head >= block_buffer_tail) {
         return (config->_planner_blocks - 1) - (block_buffer_head - block_buffer_tail);
     } else {
@@ -453,5 +781,6 @@ void plan_cycle_reinitialize() {
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     Stepper::update_plan_block_parameters();
     block_buffer_planned = block_buffer_tail;
+    newest.planned       = block_buffer_tail;  // The plan before the newest block no longer holds either
     planner_recalculate();
 }
@@ -29,9 +29,9 @@ struct plan_block_t {
     // Fields used by the bresenham algorithm for tracing the line
     // NOTE: Used by stepper algorithm to execute the block correctly. Do not alter these values.
 
-    uint32_t steps[MAX_N_AXIS];  // Step count along each axis
-    uint32_t step_event_count;   // The maximum step axis count and number of steps required to complete this block.
-    uint8_t  direction_bits;     // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
+    uint32_t* steps;             // Step count along each axis, Axes::_numberAxis entries kept outside the block
+    uint32_t  step_event_count;  // The maximum step axis count and number of steps required to complete this block.
+    uint8_t   direction_bits;    // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
 
     // Block condition data to ensure correct execution depending on states and overrides.
     PlMotion     motion;       // Block bitflag motion conditions. Copied from pl_line_data.
@@ -41,34 +41,44 @@ struct plan_block_t {
 
     // Fields used by the motion planner to manage acceleration. Some of these values may be updated
     // by the stepper module during execution of special motion cases for replanning purposes.
-    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
-    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
-    //   neighboring nominal speeds with overrides in (mm/min)^2
-    float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
-    float millimeters;   // The remaining distance for this block to be executed in (mm).
+    float entry_speed_sqr;  // The current planned entry speed at block junction in (mm/min)^2
+    float acceleration;     // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+    float jerk;             // Axis-limit adjusted line jerk in (mm/min^3), 0 for no limit. Does not change.
+    float millimeters;      // The remaining distance for this block to be executed in (mm).
     // NOTE: This value may be altered by stepper algorithm during execution.
 
-    // Stored rate limiting data used by planner when changes occur.
-    float max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
-    float rapid_rate;              // Axis-limit adjusted maximum rate for this block direction in (mm/min)
-    float programmed_rate;         // Programmed rate of this block (mm/min).
+    // Stored rate limiting data used by planner when changes occur. The maximum entry speed is the lowest of
+    // the junction limit and the nominal speeds on both sides, computed as needed.
+    float    max_junction_speed_sqr;  // Junction entry speed limit based on direction vectors in (mm/min)^2
+    float    rapid_rate;              // Axis-limit adjusted maximum rate for this block direction in (mm/min)
+    float    programmed_rate;         // Programmed rate of this block (mm/min).
+    float    nominal_speed;           // Programmed rate with overrides (mm/min), cached by the planner
+    uint32_t nominal_generation;      // Override generation that nominal_speed was computed for
 
     // Stored spindle speed data used by spindle overrides and resuming methods.
     SpindleSpeed spindle_speed;  // Block spindle speed. Copied from pl_line_data.
 
+    // Raster scanline pixel powers. Copied from pl_line_data.
+    uint32_t raster_first;   // Raster ring index of the first pixel
+    uint16_t raster_pixels;  // Number of pixels, 0 if the block is not a scanline
+
     bool is_jog;
 };
 
 // Planner data prototype. Must be used when passing new motions to the planner.
 struct plan_line_data_t {
-    float        feed_rate;       // Desired feed rate for line motion. Value is ignored, if rapid motion.
-    SpindleSpeed spindle_speed;   // Desired spindle speed through line motion.
-    PlMotion     motion;          // Bitflag variable to indicate motion conditions. See defines above.
-    SpindleState spindle;         // Spindle enable state
-    CoolantState coolant;         // Coolant state
-    int32_t      line_number;     // Desired line number to report when executing.
-    bool         is_jog;          // true if this was generated due to a jog command
-    bool         limits_checked;  // true if soft limits already checked
+    float        feed_rate;        // Desired feed rate for line motion. Value is ignored, if rapid motion.
+    SpindleSpeed spindle_speed;    // Desired spindle speed through line motion.
+    PlMotion     motion;           // Bitflag variable to indicate motion conditions. See defines above.
+    SpindleState spindle;          // Spindle enable state
+    CoolantState coolant;          // Coolant state
+    int32_t      line_number;      // Desired line number to report when executing.
+    bool         is_jog;           // true if this was generated due to a jog command
+    bool         limits_checked;   // true if soft limits already checked
+    float        path_tolerance;   // G64 P: corner blending tolerance in mm, 0 for exact path (G61)
+    float        merge_tolerance;  // G64 Q: collinear merging tolerance in mm, 0 for no merging
+    uint32_t     raster_first;     // Raster ring index of the first pixel power of a scanline
+    uint16_t     raster_pixels;    // Number of pixels in a scanline, 0 for an ordinary line
 };
 
 void plan_init();
@@ -81,6 +91,8 @@ void plan_reset_buffer();  // Reset buffer only.
 // in millimeters. Feed rate specifies the speed of the motion. If feed rate is inverted, the feed
 // rate is taken to mean "frequency" and would complete the operation in 1/feed_rate minutes.
 // Returns true on success.
+// In continuous mode (G64), the line may instead be merged into the newest block or joined to it by
+// a blended corner, as long as the step generator has not started on that block yet.
 bool plan_buffer_line(float* target, plan_line_data_t* pl_data);
 
 // Called when the current block is no longer needed. Discards the block and makes the memory
@@ -93,8 +105,11 @@ plan_block_t* plan_get_system_motion_block();
 // Gets the current block. Returns NULL if buffer empty
 plan_block_t* plan_get_current_block();
 
+// Gets the block offset blocks after the current one. Returns NULL past the newest block
+plan_block_t* plan_get_block(uint16_t offset);
+
 // Increment block index with wrap-around
-static uint8_t plan_next_block_index(uint8_t block_index);
+static uint16_t plan_next_block_index(uint16_t block_index);
 
 // Called by step segment buffer when computing executing block velocity profile.
 float plan_get_exec_block_exit_speed_sqr();
@@ -112,7 +127,7 @@ void plan_sync_position();
 void plan_cycle_reinitialize();
 
 // Returns the number of available blocks are in the planner buffer.
-uint8_t plan_get_block_buffer_available();
+uint16_t plan_get_block_buffer_available();
 
 // Returns the status of the block ring buffer. True, if buffer is full.
 uint8_t plan_check_full_buffer();
@@ -5,15 +5,23 @@
 #include "Probe.h"
 #include "Machine/EventPin.h"
 #include "Machine/MachineConfig.h"
+#include "Stepping.h"
+#include "Protocol.h"  // protocol_send_event_from_ISR()
 
 extern void    protocol_do_probe(void* arg);
 const ArgEvent probeEvent { protocol_do_probe };
 
 Probe::ProbeEventPin::ProbeEventPin(const char* legend) : EventPin(&probeEvent, legend) {}
 
+// A pin can be latched from the step ISR if reading it is just a GPIO read
+static bool isr_readable(Pin& pin) {
+    return pin.undefined() || pin.capabilities().has(Pins::PinCapabilities::ISR);
+}
+
 void Probe::init() {
     _probePin.init();
     _toolsetterPin.init();
+    _isrLatch = exists() && isr_readable(_probePin) && isr_readable(_toolsetterPin);
 }
 
 void Probe::set_direction(bool away) {
@@ -30,6 +38,34 @@ bool Probe::tripped() {
     return get_state() ^ _away;
 }
 
+void Probe::arm() {
+    _latched = false;
+}
+
+void IRAM_ATTR Probe::latch() {
+    if (!_isrLatch || _latched.load(std::memory_order_relaxed)) {
+        return;
+    }
+    bool active = (_probePin.defined() && _probePin.read()) || (_toolsetterPin.defined() && _toolsetterPin.read());
+    if (active ^ _away) {
+        for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+            _latchedSteps[axis] = Stepping::getSteps(axis);
+        }
+        _latched.store(true, std::memory_order_release);
+        protocol_send_event_from_ISR(&probeEvent, this);
+    }
+}
+
+bool Probe::latchedSteps(int32_t* steps) {
+    if (!_latched.load(std::memory_order_acquire)) {
+        return false;
+    }
+    for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+        steps[axis] = _latchedSteps[axis];
+    }
+    return true;
+}
+
 void Probe::validate() {}
 
 void Probe::group(Configuration::HandlerBase& handler) {
@@ -40,15 +76,23 @@ void Probe::group(Configuration::HandlerBase& handler) {
 }
 void protocol_do_probe(void* arg) {
     Probe* p = config->_probe;
-    if (p->tripped() && probing) {
-        probing = false;
-        get_motor_steps(probe_steps);
-        if (p->_hard_stop) {
-            Stepper::reset();
-            plan_reset();
-            sys.state = State::Idle;
-        } else {
-            protocol_do_motion_cancel();
+    if (!probing) {
+        return;
+    }
+    // Prefer the position that the step ISR latched when the probe tripped.
+    // The current position includes the travel since then.
+    if (!p->latchedSteps(probe_steps)) {
+        if (!p->tripped()) {
+            return;
         }
+        get_motor_steps(probe_steps);
+    }
+    probing = false;
+    if (p->_hard_stop) {
+        Stepper::reset();
+        plan_reset();
+        sys.state = State::Idle;
+    } else {
+        protocol_do_motion_cancel();
     }
 }
@@ -6,7 +6,9 @@
 
 #include "Configuration/HandlerBase.h"
 #include "Configuration/Configurable.h"
+#include "Config.h"  // MAX_N_AXIS
 
+#include <atomic>
 #include <cstdint>
 
 class Probe : public Configuration::Configurable {
@@ -27,6 +29,13 @@ class Probe : public Configuration::Configurable {
     ProbeEventPin _probePin;
     ProbeEventPin _toolsetterPin;
 
+    // Position latched by the step ISR when the probe trips.  The ISR samples the
+    // pins right after each step, so the latched position does not depend on how
+    // long the probe event takes to reach protocol_do_probe().
+    bool              _isrLatch = false;  // The pins can be read from the step ISR
+    std::atomic<bool> _latched { false };
+    int32_t           _latchedSteps[MAX_N_AXIS];
+
 public:
     bool _hard_stop = false;
     // Configurable
@@ -51,6 +60,16 @@ public:
     // Returns true if the probe pin is tripped, depending on the direction (away or not)
     bool IRAM_ATTR tripped();
 
+    // Clears the latched position before a probing motion
+    void arm();
+
+    // Called by the step ISR while probing.  Reads the pins directly and latches
+    // the motor steps the first time the probe trips.
+    void IRAM_ATTR latch();
+
+    // Copies the latched position to steps.  Returns false if there is none.
+    bool latchedSteps(int32_t* steps);
+
     ProbeEventPin& probePin() { return _probePin; }
     ProbeEventPin& toolsetterPin() { return _toolsetterPin; }
 
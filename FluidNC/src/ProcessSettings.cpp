@@ -21,8 +21,12 @@
 #include "FileStream.h"           // FileStream()
 #include "StartupLog.h"           // startupLog
 #include "Driver/gpio_dump.h"     // gpio_dump()
+#include "Driver/delay_usecs.h"   // ticks_per_us
+#include "Stepper.h"              // Stepper::isr_stats, Stepper::underrun_stats
 #include "FileCommands.h"         // make_file_commands()
+#include "Raster.h"               // make_raster_commands()
 #include "Job.h"                  // Job::active()
+#include "GCodeCache.h"           // GCodeCache::text(), make_gcode_cache_commands()
 
 #include "FluidPath.h"
 #include "HashFS.h"
@@ -176,6 +180,8 @@ extern void make_user_commands();
 void settings_init() {
     make_settings();
     make_file_commands();
+    make_raster_commands();
+    make_gcode_cache_commands();
 }
 
 static Error show_help(const char* value, AuthenticationLevel auth_level, Channel& out) {
@@ -890,6 +896,60 @@ static Error showHeap(const char* value, AuthenticationLevel auth_level, Channel
     return Error::Ok;
 }
 
+static Error showIsrStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (strcasecmp(value, "reset")) {
+            return Error::InvalidValue;
+        }
+        Stepper::reset_isr_stats();
+        return Error::Ok;
+    }
+    auto  isr = Stepper::isr_stats;  // Snapshot, since the ISR keeps changing it
+    float us  = float(ticks_per_us);
+    if (!isr.count) {
+        log_info_to(out, "Step ISR has not run");
+        return Error::Ok;
+    }
+    log_info_to(out,
+                "Step ISR calls:" << isr.count << " min:" << setprecision(2) << isr.min_cycles / us << "us avg:" << setprecision(2)
+                                  << isr.total_cycles / isr.count / us << "us max:" << setprecision(2) << isr.max_cycles / us
+                                  << "us late:" << isr.late);
+    log_info_to(out,
+                "Segments:" << Stepper::segment_depth() << " blocks:" << Stepper::segment_blocks() << " low water:" << isr.low_water
+                            << " pulse_us:" << Stepping::_pulseUsecs);
+    if (Stepping::engineUnderruns()) {
+        log_info_to(out, "Engine underruns:" << Stepping::engineUnderruns());
+    }
+    // The ISR runs once per step pulse at most, so its longest run bounds the step rate
+    if (!isr.max_cycles) {
+        log_info_to(out, "Max pulses/sec engine:" << Stepping::maxPulsesPerSec());
+        return Error::Ok;
+    }
+    log_info_to(out, "Max pulses/sec engine:" << Stepping::maxPulsesPerSec() << " ISR:" << uint32_t(1000000 * us / isr.max_cycles));
+    return Error::Ok;
+}
+
+static Error showUnderruns(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (strcasecmp(value, "reset")) {
+            return Error::InvalidValue;
+        }
+        Stepper::reset_underrun_stats();
+        return Error::Ok;
+    }
+    auto stats = Stepper::underrun_stats;  // Snapshot, since the ISR can add to it
+    log_info_to(out,
+                "Underruns:" << stats.count << " total:" << uint32_t(stats.total_usecs / 1000) << "ms longest:" << stats.max_usecs / 1000
+                             << "ms at line " << stats.max_line);
+    // List the most recent ones, oldest first
+    uint32_t n = std::min(stats.count, uint32_t(Stepper::underrun_stats_t::LOG_SIZE));
+    for (uint32_t i = stats.count - n; i < stats.count; i++) {
+        auto& u = stats.log[i % Stepper::underrun_stats_t::LOG_SIZE];
+        log_info_to(out, "Underrun at line " << u.line_number << " " << u.usecs / 1000 << "ms");
+    }
+    return Error::Ok;
+}
+
 // Commands use the same syntax as Settings, but instead of setting or
 // displaying a persistent value, a command causes some action to occur.
 // That action could be anything, from displaying a run-time parameter
@@ -945,6 +1005,8 @@ void make_user_commands() {
 
     new UserCommand("SA", "Alarm/Send", sendAlarm, anyState);
     new UserCommand("Heap", "Heap/Show", showHeap, anyState);
+    new UserCommand("ISR", "Stepper/ISR", showIsrStats, anyState);
+    new UserCommand("UR", "Stepper/Underruns", showUnderruns, anyState);
     new UserCommand("SS", "Startup/Show", showStartupLog, anyState);
     new UserCommand("UP", "Uart/Passthrough", uartPassthrough, notIdleOrAlarm);
 
@@ -1098,29 +1160,32 @@ Error settings_execute_line(const char* line, Channel& out, AuthenticationLevel
     return do_command_or_setting(key, value, auth_level, out);
 }
 
-Error execute_line(const char* line, Channel& channel, AuthenticationLevel auth_level) {
-    // Empty or comment line. For syncing purposes.
-    if (line[0] == 0) {
-        return Error::Ok;
-    }
-    // Skip leading whitespace
-    while (isspace(*line)) {
-        ++line;
-    }
-    // User '$' or WebUI '[ESPxxx]' command
-    if (line[0] == '$' || line[0] == '[') {
-        if (gc_state.skip_blocks) {
+Error execute_line(const char* line, Channel& channel, AuthenticationLevel auth_level, const gc_words_t* words) {
+    // Compiled lines are always gcode
+    if (!words) {
+        // Empty or comment line. For syncing purposes.
+        if (line[0] == 0) {
             return Error::Ok;
         }
-        return settings_execute_line(line, channel, auth_level);
+        // Skip leading whitespace
+        while (isspace(*line)) {
+            ++line;
+        }
+        // User '$' or WebUI '[ESPxxx]' command
+        if (line[0] == '$' || line[0] == '[') {
+            if (gc_state.skip_blocks) {
+                return Error::Ok;
+            }
+            return settings_execute_line(line, channel, auth_level);
+        }
     }
     // Everything else is gcode. Block if in alarm or jog mode.
     if (state_is(State::Alarm) || state_is(State::ConfigAlarm) || state_is(State::Jog)) {
         return Error::SystemGcLock;
     }
-    Error result = gc_execute_line(line);
+    Error result = gc_execute_line(line, words);
     if (result != Error::Ok && result != Error::Reset) {
-        log_error_to(channel, "Bad GCode: " << line);
+        log_error_to(channel, "Bad GCode: " << (words ? GCodeCache::text(*words) : std::string(line)));
         if (Job::active()) {
             send_alarm(ExecAlarm::GCodeError);
         }
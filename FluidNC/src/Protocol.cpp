@@ -20,6 +20,7 @@
 #include "SettingsDefinitions.h"  // gcode_echo
 #include "Machine/LimitPin.h"
 #include "Job.h"
+#include "GCodeCache.h"  // GCodeCache::text()
 #include "Driver/restart.h"
 
 volatile ExecAlarm lastAlarm;  // The most recent alarm code
@@ -283,12 +284,13 @@ void protocol_main_loop() {
     for (;; vTaskDelay(0)) {
         if (activeChannel) {
             // The input polling task has collected a line of input
+            auto words = activeChannel->compiledLine();
             if (gcode_echo->get()) {
-                report_echo_line_received(activeLine, allChannels);
+                report_echo_line_received(words ? GCodeCache::text(*words).c_str() : activeLine, allChannels);
             }
 
             Channel* out_channel = Job::leader ? Job::leader : activeChannel;
-            Error    status_code = execute_line(activeLine, *out_channel, AuthenticationLevel::LEVEL_GUEST);
+            Error    status_code = execute_line(activeLine, *out_channel, AuthenticationLevel::LEVEL_GUEST, words);
 
             // Tell the channel that the line has been processed.
             // If the line was aborted, the channel could be invalid
@@ -466,7 +468,7 @@ static void protocol_do_start() {
 }
 
 static void protocol_do_alarm(void* alarmVoid) {
-    lastAlarm = (ExecAlarm)((int)alarmVoid);
+    lastAlarm = (ExecAlarm)((intptr_t)alarmVoid);
     if (spindle->_off_on_alarm) {
         spindle->stop();
     }
@@ -819,6 +821,11 @@ void protocol_do_cycle_stop() {
                 Stepper::reset();
                 gc_sync_position();
                 plan_sync_position();
+            } else if (!sys.suspend.value && (state_is(State::Cycle) || state_is(State::Jog)) && Stepper::resume_queued()) {
+                // Prep added segments after the step ISR found the buffer empty and stopped. Going
+                // to Idle would strand them, since there may be no planner block left to trigger
+                // another cycle start, so keep the motion going instead.
+                break;
             }
             if (sys.suspend.bit.safetyDoorAjar) {  // Only occurs when safety door opens during jog.
                 sys.suspend.bit.jogCancel    = false;
@@ -859,14 +866,8 @@ static void protocol_do_late_reset() {
     unwind_cause = "Reset";
 }
 
-void protocol_exec_rt_system() {
-    if (rtSafetyDoor) {
-        protocol_do_safety_door();
-    }
-
-    protocol_handle_events();
-
-    // Reload step segment buffer
+void protocol_prep_buffer() {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     switch (sys.state) {
         case State::ConfigAlarm:
         case State::Alarm:
@@ -884,6 +885,20 @@ void protocol_exec_rt_system() {
     }
 }
 
+void protocol_exec_rt_system() {
+    // Event handlers change the planner and step control state
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+
+    if (rtSafetyDoor) {
+        protocol_do_safety_door();
+    }
+
+    protocol_handle_events();
+
+    // Reload step segment buffer
+    protocol_prep_buffer();
+}
+
 static void protocol_manage_spindle() {
     // Feed hold manager. Controls spindle stop override states.
     // NOTE: Hold ensured as completed by condition check at the beginning of suspend routine.
@@ -1001,7 +1016,7 @@ static void protocol_exec_rt_suspend() {
 }
 
 static void protocol_do_feed_override(void* incrementvp) {
-    int increment = int(incrementvp);
+    int increment = intptr_t(incrementvp);
     int percent;
     if (increment == FeedOverride::Default) {
         percent = FeedOverride::Default;
@@ -1021,7 +1036,7 @@ static void protocol_do_feed_override(void* incrementvp) {
 }
 
 static void protocol_do_rapid_override(void* percentvp) {
-    int percent = int(percentvp);
+    int percent = intptr_t(percentvp);
     if (percent != sys.r_override) {
         sys.r_override = percent;
         update_velocities();
@@ -1031,7 +1046,7 @@ static void protocol_do_rapid_override(void* percentvp) {
 
 static void protocol_do_spindle_override(void* incrementvp) {
     int percent;
-    int increment = int(incrementvp);
+    int increment = intptr_t(incrementvp);
     if (increment == SpindleSpeedOverride::Default) {
         percent = SpindleSpeedOverride::Default;
     } else {
@@ -1057,7 +1072,7 @@ static void protocol_do_spindle_override(void* incrementvp) {
 }
 
 static void protocol_do_accessory_override(void* type) {
-    switch (int(type)) {
+    switch (intptr_t(type)) {
         case AccessoryOverride::SpindleStopOvr:
             // Spindle stop override allowed only while in HOLD state.
             if (state_is(State::Hold)) {
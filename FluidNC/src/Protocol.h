@@ -34,6 +34,9 @@ void protocol_main_loop();
 void protocol_execute_realtime();
 void protocol_exec_rt_system();
 
+// Reloads the step segment buffer if the machine is in a motion state
+void protocol_prep_buffer();
+
 // Executes the auto cycle feature, if enabled.
 void protocol_auto_cycle_start();
 
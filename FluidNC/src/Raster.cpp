@@ -0,0 +1,198 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Raster.h"
+
+#include "Machine/MachineConfig.h"
+#include "Settings.h"       // AsyncUserCommand
+#include "MotionControl.h"  // mc_linear()
+#include "Protocol.h"       // protocol_execute_realtime()
+#include "GCode.h"          // gc_state
+#include "Job.h"            // Job::active()
+
+#include <esp_attr.h>  // IRAM_ATTR
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace Raster {
+    // Each scanline takes its pixels plus one more entry, the power after the scanline,
+    // in one contiguous run.  The indices run freely and are masked on access.
+    static uint32_t ring[ringPixels];
+
+    static uint32_t              head = 0;    // Written only by the command
+    static std::atomic<uint32_t> tail { 0 };  // Written only by the step ISR, except in reset()
+
+    void reset() { tail.store(head, std::memory_order_release); }
+
+    uint32_t IRAM_ATTR power(uint32_t index) { return ring[index & (ringPixels - 1)]; }
+
+    void IRAM_ATTR release(uint32_t end) { tail.store(end, std::memory_order_release); }
+
+    // Finds room for n contiguous entries, letting motion continue while it waits
+    // for the step ISR to finish older scanlines.  Returns false on abort.
+    static bool reserve(uint32_t n, uint32_t& first) {
+        uint32_t start  = head;
+        uint32_t offset = start & (ringPixels - 1);
+        if (offset + n > ringPixels) {
+            start += ringPixels - offset;  // Skip to the beginning rather than wrap around the end
+        }
+        while (start + n - tail.load(std::memory_order_acquire) > ringPixels) {
+            protocol_auto_cycle_start();
+            protocol_execute_realtime();
+            if (sys.abort) {
+                return false;
+            }
+        }
+        first = start;
+        return true;
+    }
+
+    static int base64_value(char c) {
+        if (c >= 'A' && c <= 'Z') {
+            return c - 'A';
+        }
+        if (c >= 'a' && c <= 'z') {
+            return c - 'a' + 26;
+        }
+        if (c >= '0' && c <= '9') {
+            return c - '0' + 52;
+        }
+        if (c == '+') {
+            return 62;
+        }
+        if (c == '/') {
+            return 63;
+        }
+        return -1;
+    }
+
+    // Decodes base64 into dest, which has room for the decoded length.  Returns the
+    // number of bytes, or -1 if the data is malformed.
+    static int base64_decode(const char* data, size_t len, uint8_t* dest) {
+        if (len == 0 || len % 4) {
+            return -1;
+        }
+        int n = 0;
+        for (size_t i = 0; i < len; i += 4) {
+            int pad = 0;
+            if (i + 4 == len) {
+                pad = (data[i + 3] == '=') + (data[i + 2] == '=');
+            }
+            uint32_t bits = 0;
+            for (int j = 0; j < 4 - pad; j++) {
+                int value = base64_value(data[i + j]);
+                if (value < 0) {
+                    return -1;
+                }
+                bits |= value << (18 - 6 * j);
+            }
+            dest[n++] = bits >> 16;
+            if (pad < 2) {
+                dest[n++] = bits >> 8;
+            }
+            if (pad < 1) {
+                dest[n++] = bits;
+            }
+        }
+        return n;
+    }
+
+    static bool gcode_locked() { return state_is(State::Alarm) || state_is(State::ConfigAlarm) || state_is(State::Jog); }
+
+    static Error line(const char* value, AuthenticationLevel auth_level, Channel& out) {
+        if (!value) {
+            return Error::InvalidStatement;
+        }
+
+        // Scan axis and pixel pitch
+        int axis = -1;
+        for (int i = 0; i < Axes::_numberAxis; i++) {
+            if (Axes::axisName(i) == toupper(*value)) {
+                axis = i;
+            }
+        }
+        if (axis < 0) {
+            return Error::GcodeNoAxisWords;
+        }
+        char* end;
+        float pitch = strtof(value + 1, &end);
+        if (end == value + 1 || *end != ',') {
+            return Error::BadNumberFormat;
+        }
+        if (gc_state.modal.units == Units::Inches) {
+            pitch *= MM_PER_INCH;
+        }
+
+        // Pixels
+        const char* data = end + 1;
+        size_t      len  = strlen(data);
+        uint8_t     pixels[LINE_BUFFER_SIZE * 3 / 4];
+        if (len > LINE_BUFFER_SIZE) {
+            return Error::LineLengthExceeded;
+        }
+        int n = base64_decode(data, len, pixels);
+        if (n <= 0) {
+            return Error::InvalidValue;
+        }
+
+        if (!config->_kinematics->one_block_per_line()) {
+            return Error::GcodeUnsupportedCommand;
+        }
+        if (gc_state.modal.feed_rate == FeedRate::InverseTime || gc_state.feed_rate == 0.0f) {
+            return Error::GcodeUndefinedFeedRate;
+        }
+        // A scanline shorter than a step would plan no block, so nothing would release its pixels
+        float length = n * pitch;
+        if (fabsf(length) * config->_axes->_axis[axis]->_stepsPerMm < 1.0f) {
+            return Error::GcodeInvalidTarget;
+        }
+
+        uint32_t first;
+        if (!reserve(n + 1, first)) {
+            return Error::Reset;
+        }
+
+        // Map the pixels to device powers now, so the step ISR only has to look them up.
+        // mapSpeed() applies the spindle speed override as it is at this point.
+        uint32_t* powers = &ring[first & (ringPixels - 1)];
+        int       last   = -1;
+        uint32_t  dev_speed = 0;
+        for (int i = 0; i < n; i++) {
+            if (pixels[i] != last) {
+                last      = pixels[i];
+                dev_speed = spindle->mapSpeed(gc_state.modal.spindle, SpindleSpeed(gc_state.spindle_speed * last / 255));
+            }
+            powers[i] = dev_speed;
+        }
+        powers[n] = spindle->mapSpeed(gc_state.modal.spindle, 0);  // Off at the end of the scanline
+        head      = first + n + 1;
+
+        plan_line_data_t plan_data = {};
+        plan_data.feed_rate        = gc_state.feed_rate;
+        plan_data.spindle_speed    = gc_state.spindle_speed;
+        plan_data.spindle          = gc_state.modal.spindle;
+        plan_data.coolant          = gc_state.modal.coolant;
+        plan_data.raster_first     = first;
+        plan_data.raster_pixels    = n;
+        if (Job::active()) {
+            plan_data.line_number = Job::channel()->lineNumber();
+        }
+
+        float target[MAX_N_AXIS];
+        copyAxes(target, gc_state.position);
+        target[axis] += length;
+        if (!mc_linear(target, &plan_data, gc_state.position)) {
+            head = first;  // Not planned, so take the pixels back and stay put
+            return Error::Ok;
+        }
+        copyAxes(gc_state.position, target);
+        return Error::Ok;
+    }
+}
+
+void make_raster_commands() {
+    new AsyncUserCommand("RL", "Raster/Line", Raster::line, Raster::gcode_locked);
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Raster.h - laser raster scanlines
+
+  A scanline is a straight move along one axis with a power for each pixel, sent as
+
+    $Raster/Line=<axis><pitch>,<pixels>      e.g.  $RL=X-0.1,AAAQIEBggP8=
+
+  The line starts at the current position and runs for one pitch per pixel, in the
+  direction of the pitch's sign, at the current feed rate.  pitch is in the current
+  units.  pixels is base64, one byte per pixel, each scaling the current S value by
+  pixel/255.  The whole scanline is one planner block, and the step ISR changes the
+  power at the pixel boundaries, so a scanline costs one command instead of one
+  G1 line per pixel.  A long scanline can be sent as several commands; collinear
+  blocks join at full speed.
+
+  The power is constant across each pixel, with no M4 speed compensation, so the
+  sender should overscan so that the pixels lie in the cruise part of the line.
+  The spindle speed override is applied to the powers when the scanline is received,
+  so a change of the override takes effect from the next scanline that is sent, not
+  on the scanlines that are already queued.
+*/
+
+#include <cstdint>
+
+namespace Raster {
+    // Pixel powers, mapped to the spindle's device units, are kept in a ring that the
+    // planner blocks refer to.  The step ISR releases them when it finishes a scanline.
+    const uint32_t ringPixels = 2048;  // A power of two
+
+    // Empties the ring.  Called when the planner and stepper are reset.
+    void reset();
+
+    // Device power of a pixel (ISR-safe)
+    uint32_t power(uint32_t index);
+
+    // Returns the pixels of a finished scanline to the ring (ISR-safe)
+    void release(uint32_t end);
+}
+
+void make_raster_commands();
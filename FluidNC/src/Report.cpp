@@ -30,6 +30,7 @@
 #include "WebUI/NotificationsService.h"  // WebUI::notificationsService
 #include "InputFile.h"
 #include "Job.h"
+#include "Driver/delay_usecs.h"  // ticks_per_us
 
 #include <map>
 #include <freertos/task.h>
@@ -56,7 +57,7 @@ void notifyf(const char* title, const char* format, ...) {
     va_list copy;
     va_start(arg, format);
     va_copy(copy, arg);
-    size_t len = vsnprintf(NULL, 0, format, arg);
+    size_t len = vsnprintf(NULL, 0, format, copy);
     va_end(copy);
     if (len >= sizeof(loc_buf)) {
         temp = new char[len + 1];
@@ -317,6 +318,11 @@ void report_gcode_modes(Channel& channel) {
             break;
     }
 
+    // G61 is the default and is not reported, as before G64 was supported
+    if (gc_state.modal.control == ControlMode::Continuous) {
+        msg << " G64";
+    }
+
     //report_util_gcode_modes_M();
     switch (gc_state.modal.program_flow) {
         case ProgramFlow::Running:
@@ -611,9 +617,10 @@ void report_realtime_status(Channel& channel) {
     if (Job::active()) {
         msg << "|" << Job::channel()->_progress;
     }
-#ifdef DEBUG_STEPPER_ISR
-    msg << "|ISRs:" << Stepper::isr_count;
-#endif
+    if (bits_are_true(status_mask->get(), RtStatus::IsrTiming)) {
+        auto& isr = Stepper::isr_stats;
+        msg << "|ISR:" << setprecision(1) << float(isr.max_cycles) / ticks_per_us << "," << isr.late << "," << isr.low_water;
+    }
 #ifdef DEBUG_REPORT_HEAP
     msg << "|Heap:" << xPortGetFreeHeapSize();
 #endif
@@ -17,8 +17,9 @@
 
 // Define status reporting boolean enable bit flags in status_report_mask
 enum RtStatus {
-    Position = bitnum_to_mask(0),
-    Buffer   = bitnum_to_mask(1),
+    Position  = bitnum_to_mask(0),
+    Buffer    = bitnum_to_mask(1),
+    IsrTiming = bitnum_to_mask(2),
 };
 
 const char* errorString(Error errorNumber);
@@ -0,0 +1,144 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SCurve.h"
+
+#include <cmath>
+
+// Iterations for the bisection searches.  Each one halves the interval, so
+// this reaches float resolution.
+static const int bisections = 24;
+
+static float ramp_time(float dv, float acceleration, float jerk) {
+    if (dv * jerk >= acceleration * acceleration) {
+        return dv / acceleration + acceleration / jerk;
+    }
+    return 2.0f * sqrtf(dv / jerk);
+}
+
+void SCurveRamp::start(float v0, float v1, float acceleration, float jerk) {
+    float dv = fabsf(v1 - v0);
+
+    _v0   = v0;
+    _dv   = v1 - v0;
+    _jerk = v1 < v0 ? -jerk : jerk;
+    if (dv * jerk >= acceleration * acceleration) {
+        _tJerk  = acceleration / jerk;
+        _tConst = dv / acceleration - _tJerk;
+    } else {
+        _tJerk  = sqrtf(dv / jerk);
+        _tConst = 0.0f;
+    }
+}
+
+float SCurveRamp::speed(float t) const {
+    if (t <= 0.0f) {
+        return _v0;
+    }
+    if (t < _tJerk) {
+        return _v0 + 0.5f * _jerk * t * t;
+    }
+    if (t < _tJerk + _tConst) {
+        return _v0 + _jerk * _tJerk * (t - 0.5f * _tJerk);
+    }
+    float tau = duration() - t;  // Time left in the ramp
+    if (tau <= 0.0f) {
+        return _v0 + _dv;
+    }
+    return _v0 + _dv - 0.5f * _jerk * tau * tau;
+}
+
+float SCurveRamp::distance(float t) const {
+    if (t <= 0.0f) {
+        return 0.0f;
+    }
+    float total = duration();
+    if (t >= total) {
+        return (_v0 + 0.5f * _dv) * total;
+    }
+    if (t < _tJerk) {
+        return t * (_v0 + _jerk * t * t / 6.0f);
+    }
+    if (t < _tJerk + _tConst) {
+        float tau = t - _tJerk;  // Time into the constant-acceleration phase
+        return _v0 * t + _jerk * _tJerk * (_tJerk * _tJerk / 6.0f + 0.5f * _tJerk * tau + 0.5f * tau * tau);
+    }
+    // The last phase mirrors the first, so measure back from the end
+    float tau = total - t;
+    return (_v0 + 0.5f * _dv) * total - tau * (_v0 + _dv - _jerk * tau * tau / 6.0f);
+}
+
+float SCurveRamp::timeAt(float d) const {
+    float lo = 0.0f;
+    float hi = duration();
+    if (d >= distance(hi)) {
+        return hi;
+    }
+    // The speed is never negative, so distance() is monotonic
+    for (int i = 0; i < bisections; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (distance(mid) < d) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5f * (lo + hi);
+}
+
+float scurve_ramp_distance(float v0, float v1, float acceleration, float jerk) {
+    return 0.5f * (v0 + v1) * ramp_time(fabsf(v1 - v0), acceleration, jerk);
+}
+
+float scurve_reach_speed(float v0, float distance, float acceleration, float jerk) {
+    if (distance <= 0.0f) {
+        return v0;
+    }
+
+    // Speed change at which the ramp just reaches the acceleration limit
+    float dv_limit = acceleration * acceleration / jerk;
+
+    if (distance >= (v0 + 0.5f * dv_limit) * 2.0f * acceleration / jerk) {
+        // The ramp has a constant-acceleration phase, so (v0 + dv/2) * (dv/a + a/j) = distance.
+        // That is a quadratic in dv; the root is written in the form that avoids cancellation.
+        float b = 2.0f * v0 + dv_limit;
+        float c = 2.0f * acceleration * (v0 * acceleration / jerk - distance);  // Negative here
+        return v0 - 2.0f * c / (b + sqrtf(b * b - 4.0f * c));
+    }
+
+    // Jerk phases only, so (v0 + dv/2) * 2 * sqrt(dv/j) = distance.  With s = sqrt(dv) that is
+    // s^3 + 2*v0*s - distance*sqrt(j) = 0.  The cubic is increasing and convex for s > 0, so
+    // Newton's method converges monotonically from a start above the root, which both of the
+    // one-term approximations are.
+    float p = 2.0f * v0;
+    float q = distance * sqrtf(jerk);
+    float s = cbrtf(q);
+    if (p > 0.0f && q / p < s) {
+        s = q / p;
+    }
+    for (int i = 0; i < 4; i++) {
+        s -= (s * (s * s + p) - q) / (3.0f * s * s + p);
+    }
+    return v0 + s * s;
+}
+
+float scurve_peak_speed(float entry_speed, float exit_speed, float max_speed, float distance, float acceleration, float jerk) {
+    auto fits = [=](float v) {
+        return scurve_ramp_distance(entry_speed, v, acceleration, jerk) + scurve_ramp_distance(exit_speed, v, acceleration, jerk) <= distance;
+    };
+
+    if (fits(max_speed)) {
+        return max_speed;
+    }
+    float lo = entry_speed > exit_speed ? entry_speed : exit_speed;
+    float hi = max_speed;
+    for (int i = 0; i < bisections; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (fits(mid)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Jerk-limited speed ramps for S-curve acceleration.
+//
+// A ramp changes the speed from v0 to v1 with the acceleration rising from
+// zero at the jerk limit, holding at the acceleration limit if the speed
+// change is large enough to get there, and falling back to zero at the jerk
+// limit.  The speed curve is symmetric about the middle of the ramp, so a
+// ramp covers the average of the two speeds times its duration, just as a
+// constant-acceleration ramp does.  What differs from the trapezoid is the
+// duration: dv/acceleration + acceleration/jerk for a large change, and
+// 2*sqrt(dv/jerk) for a change too small to reach the acceleration limit.
+//
+// Units are those of plan_block_t: speeds in mm/min, acceleration in
+// mm/min^2 and jerk in mm/min^3.
+
+class SCurveRamp {
+    float _v0;      // Start speed
+    float _dv;      // Speed change, negative for deceleration
+    float _jerk;    // Jerk, negative for deceleration
+    float _tJerk;   // Duration of each of the two jerk phases
+    float _tConst;  // Duration of the constant-acceleration phase
+
+public:
+    void start(float v0, float v1, float acceleration, float jerk);
+
+    float duration() const { return 2.0f * _tJerk + _tConst; }
+
+    // Speed and distance covered at time t into the ramp
+    float speed(float t) const;
+    float distance(float t) const;
+
+    // Time at which the ramp has covered the given distance
+    float timeAt(float distance) const;
+};
+
+// Distance over which a ramp changes the speed between v0 and v1, in either direction
+float scurve_ramp_distance(float v0, float v1, float acceleration, float jerk);
+
+// Highest speed that can be reached from v0 over the distance.  Since ramps are
+// symmetric, it is also the highest speed from which v0 can be reached.
+float scurve_reach_speed(float v0, float distance, float acceleration, float jerk);
+
+// Highest speed, not above max_speed, from which a block of the given length can
+// accelerate from entry_speed and decelerate to exit_speed.
+float scurve_peak_speed(float entry_speed, float exit_speed, float max_speed, float distance, float acceleration, float jerk);
@@ -7,6 +7,7 @@
 
 #include <string_view>
 #include <map>
+#include <functional>
 #include <nvs.h>
 
 // forward declarations
@@ -421,6 +422,6 @@ public:
 // Execute the startup script lines stored in non-volatile storage upon initialization
 Error settings_execute_line(const char* line, Channel& out, AuthenticationLevel);
 Error do_command_or_setting(std::string_view key, std::string_view value, AuthenticationLevel auth_level, Channel&);
-Error execute_line(const char* line, Channel& channel, AuthenticationLevel auth_level);
+Error execute_line(const char* line, Channel& channel, AuthenticationLevel auth_level, const gc_words_t* words = nullptr);
 
 extern const enum_opt_t onoffOptions;
@@ -15,6 +15,10 @@
 namespace Spindles {
     // this is the same as a PWM spindle but the M4 compensation is supported.
     class Laser : public PWM {
+        // In M4 mode, step the power with the speed within each segment rather
+        // than once per segment, so ramps burn as evenly as the cruise.
+        bool _power_ramp = false;
+
     public:
         Laser(const char* name) : PWM(name) {};
 
@@ -24,6 +28,7 @@ namespace Spindles {
         Laser& operator=(Laser&&)      = delete;
 
         bool isRateAdjusted() override;
+        bool isPowerRamped() override { return _power_ramp; }
         void config_message() override;
         void init() override;
         void set_direction(bool Clockwise) override {};
@@ -34,6 +39,7 @@ namespace Spindles {
             // We cannot call PWM::group() because that would pick up
             // direction_pin, which we do not want in Laser
             handler.item("pwm_hz", _pwm_freq, 1000, 100000);
+            handler.item("power_ramp", _power_ramp);
             OnOff::groupCommon(handler);
         }
 
@@ -64,6 +64,7 @@ namespace Spindles {
         void            stop() { setState(SpindleState::Disable, 0); }
         virtual void    config_message() = 0;
         virtual bool    isRateAdjusted();
+        virtual bool    isPowerRamped() { return false; }
         virtual bool    use_delay_settings() const { return true; }
         virtual uint8_t get_current_tool_num() { return _current_tool; }
         virtual bool    tool_change(uint32_t tool_number, bool pre_select, bool set_tool);
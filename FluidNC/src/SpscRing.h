@@ -0,0 +1,108 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Lock-free ring buffer with one producer and one consumer, such as the
+// step segment buffer that prep_buffer() fills and the step ISR drains.
+// Each side owns one index and only reads the other.  The producer fills
+// a slot and then publishes it with a release store of head; the consumer
+// sees the slot contents once it has loaded head with acquire, and hands
+// the slot back with a release store of tail.  The two sides can therefore
+// run on different cores without a lock and without the consumer seeing a
+// partly written entry.
+//
+// The indices run freely and are masked on access, so the capacity is a
+// power of two.  The depth - the number of entries that can be in use at
+// once - may be set lower than the capacity.
+
+#include <esp_attr.h>  // IRAM_ATTR
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class SpscRing {
+    static const uint32_t cacheLine = 64;
+
+    T*       _buffer = nullptr;
+    uint32_t _mask   = 0;
+    uint32_t _depth  = 0;
+
+    // The indices are on separate cache lines so a write by one side does
+    // not invalidate the line that the other side is writing.
+    alignas(cacheLine) std::atomic<uint32_t> _head { 0 };  // Written only by the producer
+    alignas(cacheLine) std::atomic<uint32_t> _tail { 0 };  // Written only by the consumer
+
+public:
+    SpscRing() = default;
+
+    SpscRing(const SpscRing&)            = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    ~SpscRing() { delete[] _buffer; }
+
+    // Allocates storage for depth entries and empties the ring.  Neither
+    // side may be using the ring.
+    void init(uint32_t depth) {
+        uint32_t capacity = 1;
+        while (capacity < depth) {
+            capacity <<= 1;
+        }
+        delete[] _buffer;
+        _buffer = new T[capacity];
+        _mask   = capacity - 1;
+        _depth  = depth;
+        clear();
+    }
+
+    // Empties the ring.  Neither side may be using the ring.
+    void clear() {
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t capacity() const { return _mask + 1; }
+    uint32_t depth() const { return _depth; }
+
+    // Changes the depth, up to the capacity.  Producer side; entries beyond a lower
+    // depth stay in the ring until the consumer takes them.
+    void setDepth(uint32_t depth) { _depth = depth < capacity() ? depth : capacity(); }
+
+    // Number of entries in use.  The other side may change it at any time.
+    uint32_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+
+    // Producer side
+
+    bool full() const { return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire) >= _depth; }
+
+    // The slot that the next push() will publish.  Valid only when !full().
+    T* slot() { return &_buffer[_head.load(std::memory_order_relaxed) & _mask]; }
+
+    // Publishes the slot returned by slot() to the consumer
+    void push() { _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // The oldest entry that the consumer has not handed back, or nullptr if the ring
+    // is empty.  The consumer may hand it back at any time, so the answer can be stale,
+    // but only the producer writes entries, so the entry itself stays intact.
+    const T* oldest() const {
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (_head.load(std::memory_order_relaxed) == tail) {
+            return nullptr;
+        }
+        return &_buffer[tail & _mask];
+    }
+
+    // Consumer side
+
+    // The oldest published entry, or nullptr if the ring is empty
+    inline T* IRAM_ATTR front() {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail) {
+            return nullptr;
+        }
+        return &_buffer[tail & _mask];
+    }
+
+    // Returns the entry returned by front() to the producer
+    inline void IRAM_ATTR pop() { _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
@@ -15,50 +15,140 @@
 #include "StepperPrivate.h"
 #include "Planner.h"
 #include "Protocol.h"
+#include "SpscRing.h"
+#include "SCurve.h"
+#include "Raster.h"
+#include "Driver/benchmark.h"
+#include "Driver/delay_usecs.h"  // getCpuTicks()
 #include <esp_attr.h>  // IRAM_ATTR
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
 #include <cmath>
+#include <atomic>
 
 using namespace Stepper;
 
 static bool awake = false;
 
+std::recursive_mutex Stepper::prep_mutex;
+
+// The step ISR wakes the prep task when the segment buffer holds fewer than this many segments
+static uint32_t     prep_watermark = 0;
+static TaskHandle_t prepTask       = nullptr;
+
+static uint32_t segment_depth_normal = 0;      // Segment buffer depth outside low latency mode
+static bool     low_latency          = false;  // Short segment buffer of short segments, for homing and probing
+
 // Stores the planner block Bresenham algorithm execution data for the segments in the segment
-// buffer. Normally, this buffer is partially in-use, but, for the worst case scenario, it will
-// never exceed the number of accessible stepper buffer segments (Stepping::_segments-1).
+// buffer. The entries are used in turn, so the ones in use run from the block of the oldest
+// segment in the buffer to the block being prepped. Prep waits for the oldest one to finish
+// before reusing it, so the pool can have fewer entries than the segment buffer.
 // NOTE: This data is copied from the prepped planner blocks so that the planner blocks may be
 // discarded when entirely consumed and completed by the segment buffer. Also, AMASS alters this
 // data for its own use.
+// The per-axis step counts are kept apart in st_block_steps, Axes::_numberAxis entries per block,
+// so a block takes only as much space as the configured axes need and the ISR reads them from
+// one short run of memory.
 struct st_block_t {
-    uint32_t steps[MAX_N_AXIS];
     uint32_t step_event_count;
     uint8_t  direction_bits;
     bool     is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
+    uint8_t  raster_bit;            // Step bit of the scanline axis, 0 if the block is not a raster scanline
+    uint16_t raster_pixels;         // Number of pixels in the scanline
+    uint32_t raster_first;          // Raster ring index of the first pixel
 };
 static volatile st_block_t* st_block_buffer = nullptr;
+static volatile uint32_t*   st_block_steps  = nullptr;  // Step counts, indexed by st_block_index * n_axis + axis
+static uint32_t             st_blocks       = 0;        // Entries in st_block_buffer
+static const uint16_t       no_block        = 0xffff;   // stepper_t::exec_block_index when no block is loaded
 
 // Primary stepper segment ring buffer. Contains small, short line segments for the stepper
 // algorithm to execute, which are "checked-out" incrementally from the first block in the
 // planner buffer. Once "checked-out", the steps in the segments buffer cannot be modified by
 // the planner, where the remaining planner block steps still can.
+// prep_buffer() is the only producer and the stepper ISR the only consumer, so the ring
+// needs no lock even when they run on different cores. A segment stays in the ring while
+// the ISR executes it.
 struct segment_t {
-    uint16_t     n_step;             // Number of step events to be executed for this segment
-    uint16_t     isrPeriod;          // Time to next ISR tick, in units of timer ticks
-    uint8_t      st_block_index;     // Stepper block data index. Uses this information to execute this segment.
-    uint8_t      amass_level;        // AMASS level for the ISR to execute this segment
-    uint32_t     spindle_dev_speed;  // Spindle speed scaled to the device
-    SpindleSpeed spindle_speed;      // Spindle speed in GCode units
+    int64_t  spindle_dev_step;   // Change in spindle_dev_speed per ISR tick, in 1/65536 units, for laser power ramps
+    uint32_t spindle_dev_speed;  // Spindle speed scaled to the device
+    uint32_t n_step;             // Number of step events to be executed for this segment
+    uint16_t isrPeriod;          // Time to next ISR tick, in units of timer ticks
+    uint16_t st_block_index;     // Stepper block data index. Uses this information to execute this segment.
+    uint8_t  amass_level;        // AMASS level for the ISR to execute this segment
 };
-static segment_t* segment_buffer = nullptr;
+
+// Long cruise segments at high step rates have more than 65535 steps, so n_step is 32 bits.
+// This is the most that it can hold before the AMASS shift.
+static const uint32_t max_segment_steps = UINT32_MAX >> maxAmassLevel;
+static SpscRing<segment_t> segment_ring;
+
+// Refills the segment buffer when the step ISR signals that it is running low, so stepping
+// continues while the main loop is busy with a slow line or a WebUI request. It runs at a
+// higher priority than the main loop, which still refills the buffer as before.
+static void prep_task(void* unused) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        protocol_prep_buffer();
+    }
+}
+
+// The segment buffer and st_block pool may take up to this fraction of the free heap
+static const uint32_t max_heap_fraction = 4;
 
 void Stepper::init() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
     if (st_block_buffer) {
         delete[] st_block_buffer;
+        delete[] st_block_steps;
+        st_block_buffer = nullptr;
+        st_block_steps  = nullptr;
+    }
+
+    uint32_t segments = Stepping::_segments;
+    if (Stepping::_holdLatencyMsecs) {
+        // A hold has to wait for the buffered segments, the longest of which are acceleration segments
+        segments = std::max(Stepping::_holdLatencyMsecs * Stepping::_accelerationTicks / 1000 + 1, uint32_t(6));
+    }
+
+    // One entry fewer than _segments, as when this was a ring with a wasted slot, so the
+    // step lead time is unchanged. More blocks than segments would never be used.
+    uint32_t depth = segments - 1;
+    // The pool needs at least two entries, because a new block cannot use the entry of the executing block
+    auto pool = [](uint32_t depth) { return Stepping::_segmentBlocks ? std::max(std::min(Stepping::_segmentBlocks, depth), 2u) : depth; };
+
+    // The ring capacity is rounded up to a power of two, so this overestimates a little
+    auto   block_bytes = sizeof(st_block_t) + Axes::_numberAxis * sizeof(uint32_t);
+    auto   bytes       = [&](uint32_t depth) { return depth * 2 * sizeof(segment_t) + pool(depth) * block_bytes; };
+    size_t limit       = xPortGetFreeHeapSize() / max_heap_fraction;
+    if (bytes(depth) > limit) {
+        while (depth > 5 && bytes(depth) > limit) {
+            --depth;
+        }
+        log_warn("Not enough memory for " << segments << " step segments, using " << depth + 1);
     }
-    st_block_buffer = new st_block_t[Stepping::_segments - 1];
-    if (segment_buffer) {
-        delete[] segment_buffer;
+
+    st_blocks       = pool(depth);
+    st_block_buffer = new st_block_t[st_blocks];
+    st_block_steps  = new uint32_t[st_blocks * Axes::_numberAxis];
+    segment_ring.init(depth);
+    segment_depth_normal = depth;
+    low_latency          = false;
+    prep_watermark       = segment_ring.depth() / 2;
+    reset_isr_stats();
+    reset_underrun_stats();
+
+    if (!prepTask) {
+        xTaskCreatePinnedToCore(prep_task,      // task
+                                "prep",         // name for task
+                                4096,           // size of task stack
+                                0,              // parameters
+                                5,              // priority
+                                &prepTask,      // task handle
+                                PREP_TASK_CORE  // core
+        );
     }
-    segment_buffer = new segment_t[Stepping::_segments];
 }
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
@@ -73,18 +163,26 @@ typedef struct {
     uint8_t  dir_outbits;
     uint32_t steps[MAX_N_AXIS];
 
-    uint16_t             step_count;        // Steps remaining in line segment motion
-    uint8_t              exec_block_index;  // Tracks the current st_block index. Change indicates new block.
+    uint32_t             step_count;        // Steps remaining in line segment motion
+    uint16_t             exec_block_index;  // Tracks the current st_block index. Change indicates new block.
     volatile st_block_t* exec_block;        // Pointer to the block data for the segment being executed
-    volatile segment_t*  exec_segment;      // Pointer to the segment being executed
+    segment_t*           exec_segment;      // Pointer to the segment being executed
+    uint64_t             spindle_dev_q;     // Ramped spindle_dev_speed, in 1/65536 units, 64 bits for speeds above 65535
+
+    // Raster scanline. The pixel boundaries are traced along the scanline axis with a
+    // Bresenham counter, so pixel k starts at step k * raster_steps / raster_pixels.
+    uint8_t  raster_bit;    // Step bit of the scanline axis while a scanline is running, else 0
+    uint32_t raster_steps;  // Steps along the scanline
+    uint32_t raster_acc;    // Bresenham counter for the pixel boundaries
+    uint32_t raster_pixel;  // Raster ring index of the current pixel
+    uint32_t raster_end;    // Raster ring index past the last pixel
+
+    bool     underrun;        // Waiting for prep to supply the next segment
+    uint32_t underrun_usecs;  // Length of the current underrun so far
+    int32_t  underrun_line;   // Line number of the block that prep was working on
 } stepper_t;
 static stepper_t st;
 
-// Step segment ring buffer indices
-static volatile uint32_t segment_buffer_tail;
-static volatile uint32_t segment_buffer_head;
-static uint32_t          segment_next_head;
-
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t*        pl_block;       // Pointer to the planner block being prepped
@@ -93,7 +191,7 @@ static volatile st_block_t* st_prep_block;  // Pointer to the stepper block data
 // Segment preparation data struct. Contains all the necessary information to compute new segments
 // based on the current executing planner block.
 typedef struct {
-    uint8_t  st_block_index;  // Index of stepper common data block being prepped
+    uint16_t st_block_index;  // Index of stepper common data block being prepped
     PrepFlag recalculate_flag;
 
     float dt_remainder;
@@ -101,10 +199,10 @@ typedef struct {
     float step_per_mm;
     float req_mm_increment;
 
-    uint8_t last_st_block_index;
-    float   last_steps_remaining;
-    float   last_step_per_mm;
-    float   last_dt_remainder;
+    uint16_t last_st_block_index;
+    float    last_steps_remaining;
+    float    last_step_per_mm;
+    float    last_dt_remainder;
 
     uint8_t ramp_type;    // Current segment ramp state
     float   mm_complete;  // End of velocity profile from end of current planner block in (mm).
@@ -115,9 +213,43 @@ typedef struct {
     float accelerate_until;  // Acceleration ramp end measured from end of block (mm)
     float decelerate_after;  // Deceleration ramp start measured from end of block (mm)
 
-    float        inv_rate;  // Used by PWM laser mode to speed up segment calculations.
+    // S-curve ramp state, used when the block has a jerk limit
+    SCurveRamp ramp;          // The ramp being traced
+    bool       ramp_started;  // Cleared to start a new ramp from the current speed
+    float      ramp_time;     // Time into the ramp (min)
+    float      ramp_mm;       // Ramp start measured from end of block (mm)
+    float      decel_target;  // Speed that the deceleration ramp heads for (mm/min)
+
+    float        inv_rate;    // Used by PWM laser mode to speed up segment calculations.
+    bool         ramp_power;  // Laser power follows the speed within each segment
     SpindleSpeed current_spindle_speed;
 
+    float dt_ramp;    // Segment time in the acceleration and deceleration ramps (min)
+    float dt_cruise;  // Segment time for segments that start at cruise speed (min)
+
+#ifdef PREP_FIXED_POINT
+    // Integer copy of the velocity profile for the fixed-point segment generator. Distances are
+    // in 1/65536 steps measured from the end of the block, times in 1/2^24 seconds, speeds in
+    // 1/65536 steps/sec and the acceleration in 1/65536 steps/sec^2. The float fields above
+    // remain the interface to the planner, to status reports and to the laser power code.
+    int64_t steps_remaining_q;  // Exact distance left in the block
+    int64_t dt_remainder_q;
+    int64_t mm_complete_q;
+    int64_t accelerate_until_q;
+    int64_t decelerate_after_q;
+    int64_t current_speed_q;
+    int64_t maximum_speed_q;
+    int64_t exit_speed_q;
+    int64_t acceleration_q;
+    float   q_to_mm;          // Converts a distance back to mm
+    float   q_to_mm_per_min;  // Converts a speed back to mm/min
+
+    int64_t last_steps_remaining_q;
+    int64_t last_dt_remainder_q;
+
+    int64_t dt_ramp_q;
+    int64_t dt_cruise_q;
+#endif
 } st_prep_t;
 static st_prep_t prep;
 
@@ -181,9 +313,86 @@ void IRAM_ATTR Stepper::stop_stepping() {
     st.step_outbits = 0;
 }
 
-#ifdef DEBUG_STEPPER_ISR
-uint32_t Stepper::isr_count;  // for debugging only
-#endif
+Stepper::isr_stats_t Stepper::isr_stats;
+
+static uint32_t isr_period_cycles = 0;  // CPU cycles in the step timer period that pulse_func() last set
+
+// True while prep_buffer() has a planner block with steps that are not yet in the segment buffer,
+// so the buffer running low means that prep is falling behind rather than that motion is ending.
+static std::atomic<bool> prep_pending { false };
+
+// Line number of the planner block that prep_buffer() is working on, for underrun reports
+static std::atomic<int32_t> prep_line_number { 0 };
+
+// Step timer period while the ISR waits out an underrun
+static const uint32_t underrun_poll_usecs = 100;
+static const uint32_t underrun_poll_ticks = underrun_poll_usecs * (Stepping::fStepperTimer / 1000000);
+
+Stepper::underrun_stats_t Stepper::underrun_stats;
+
+void Stepper::reset_underrun_stats() {
+    underrun_stats = {};
+}
+
+static void IRAM_ATTR end_underrun() {
+    auto& stats = Stepper::underrun_stats;
+
+    stats.log[stats.count % Stepper::underrun_stats_t::LOG_SIZE] = { st.underrun_line, st.underrun_usecs };
+    ++stats.count;
+    stats.total_usecs += st.underrun_usecs;
+    if (st.underrun_usecs > stats.max_usecs) {
+        stats.max_usecs = st.underrun_usecs;
+        stats.max_line  = st.underrun_line;
+    }
+    st.underrun = false;
+}
+
+void Stepper::reset_isr_stats() {
+    isr_stats            = {};
+    isr_stats.min_cycles = UINT32_MAX;
+    isr_stats.low_water  = segment_ring.depth();
+}
+
+static bool step_pulse();
+
+// Advances the raster pixel for a step along the scanline and sets its power. At the last
+// step, the entry past the last pixel turns the laser off and the pixels are released.
+static void IRAM_ATTR raster_step() {
+    uint32_t pixel = st.raster_pixel;
+    st.raster_acc += st.exec_block->raster_pixels;
+    while (st.raster_acc >= st.raster_steps) {
+        st.raster_acc -= st.raster_steps;
+        ++st.raster_pixel;
+    }
+    if (st.raster_pixel != pixel) {
+        spindle->setSpeedfromISR(Raster::power(st.raster_pixel));
+        if (st.raster_pixel == st.raster_end) {
+            Raster::release(st.raster_end + 1);
+            st.raster_bit = 0;
+        }
+    }
+}
+
+// Times step_pulse(), which does the work.  Reading the cycle counter is cheap enough
+// that the statistics are always collected.
+bool IRAM_ATTR Stepper::pulse_func() {
+    int32_t  start  = getCpuTicks();
+    bool     more   = step_pulse();
+    uint32_t cycles = getCpuTicks() - start;
+
+    ++isr_stats.count;
+    isr_stats.total_cycles += cycles;
+    if (cycles < isr_stats.min_cycles) {
+        isr_stats.min_cycles = cycles;
+    }
+    if (cycles > isr_stats.max_cycles) {
+        isr_stats.max_cycles = cycles;
+    }
+    if (more && cycles > isr_period_cycles) {
+        ++isr_stats.late;
+    }
+    return more;
+}
 
 /**
  * This phase of the ISR should ONLY create the pulses for the steppers.
@@ -193,10 +402,7 @@ uint32_t Stepper::isr_count;  // for debugging only
  * is to keep pulse timing as regular as possible.
  * Returns true if step interrupts should continue
  */
-bool IRAM_ATTR Stepper::pulse_func() {
-#ifdef DEBUG_STEPPER_ISR
-    isr_count++;
-#endif
+static bool IRAM_ATTR step_pulse() {
     // This is a precaution in case we get a spurious interrupt
     if (!awake) {
         return false;
@@ -206,14 +412,23 @@ bool IRAM_ATTR Stepper::pulse_func() {
     Stepping::step(st.step_outbits, st.dir_outbits);
     st.step_outbits = 0;
 
+    // Sampling the probe right after the step latches the exact position at the trip
+    if (probing) {
+        config->_probe->latch();
+    }
+
     // If there is no step segment, attempt to pop one from the stepper buffer
     if (st.exec_segment == NULL) {
         // Anything in the buffer? If so, load and initialize next step segment.
-        if (segment_buffer_head != segment_buffer_tail) {
+        st.exec_segment = segment_ring.front();
+        if (st.exec_segment != NULL) {
+            if (st.underrun) {
+                end_underrun();
+            }
             // Initialize new step segment and load number of steps to execute
-            st.exec_segment = &segment_buffer[segment_buffer_tail];
             // Initialize step segment timing per step and load number of steps to execute.
             Stepping::setTimerPeriod(st.exec_segment->isrPeriod);
+            isr_period_cycles = st.exec_segment->isrPeriod * ticks_per_us / (Stepping::fStepperTimer / 1000000);
             st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
             // If the new segment starts a new planner block, initialize stepper variables and counters.
             // NOTE: When the segment data index changes, this indicates a new planner block.
@@ -224,17 +439,52 @@ bool IRAM_ATTR Stepper::pulse_func() {
                 for (int axis = 0; axis < n_axis; axis++) {
                     st.counter[axis] = st.exec_block->step_event_count >> 1;
                 }
+                st.raster_bit = st.exec_block->raster_bit;
+                if (st.raster_bit) {
+                    st.raster_steps = st.exec_block->step_event_count >> maxAmassLevel;
+                    st.raster_acc   = 0;
+                    st.raster_pixel = st.exec_block->raster_first;
+                    st.raster_end   = st.raster_pixel + st.exec_block->raster_pixels;
+                }
             }
 
             st.dir_outbits = st.exec_block->direction_bits;
             // Adjust Bresenham axis increment counters according to AMASS level.
+            auto block_steps = &st_block_steps[st.exec_block_index * n_axis];
             for (int axis = 0; axis < n_axis; axis++) {
-                st.steps[axis] = st.exec_block->steps[axis] >> st.exec_segment->amass_level;
+                st.steps[axis] = block_steps[axis] >> st.exec_segment->amass_level;
             }
             // Set real-time spindle output as segment is loaded, just prior to the first step.
-            spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
+            // A scanline sets the power of its pixels instead.
+            if (st.raster_bit) {
+                spindle->setSpeedfromISR(Raster::power(st.raster_pixel));
+            } else {
+                st.spindle_dev_q = uint64_t(st.exec_segment->spindle_dev_speed) << 16;
+                spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
+            }
+        } else if (prep_pending.load(std::memory_order_relaxed)) {
+            // Underrun. Prep is still working on a planner block but has not kept up, so this is
+            // a stall in the middle of the motion, not its end. Poll for the next segment rather
+            // than stopping, which would send the machine to Idle until the next cycle start.
+            if (!st.underrun) {
+                st.underrun       = true;
+                st.underrun_usecs = 0;
+                st.underrun_line  = prep_line_number.load(std::memory_order_relaxed);
+                // Do not leave a laser burning in one spot while the machine is stalled
+                if (st.exec_block != NULL && (st.exec_block->is_pwm_rate_adjusted || st.raster_bit)) {
+                    spindle->setSpeedfromISR(0);
+                }
+            }
+            st.underrun_usecs += underrun_poll_usecs;
+            Stepping::setTimerPeriod(underrun_poll_ticks);
+            isr_period_cycles = underrun_poll_usecs * ticks_per_us;
+            Stepping::unstep();
+            return true;
         } else {
             // Segment buffer empty. Shutdown.
+            if (st.underrun) {
+                end_underrun();
+            }
             stop_stepping();
             if (!state_is(State::Jog)) {  // added to prevent ... jog after probing crash
                 // Ensure pwm is set properly upon completion of rate-controlled motion.
@@ -243,8 +493,10 @@ bool IRAM_ATTR Stepper::pulse_func() {
                 }
             }
 
-            protocol_send_event_from_ISR(&cycleStopEvent);
+            // Clear awake before sending the event, so that a cycle start that
+            // the event triggers in the foreground restarts the timer.
             awake = false;
+            protocol_send_event_from_ISR(&cycleStopEvent);
             Stepping::unstep();
             return false;  // Nothing to do but exit.
         }
@@ -259,11 +511,32 @@ bool IRAM_ATTR Stepper::pulse_func() {
         }
     }
 
+    // Step through the pixels of a scanline with the steps along it
+    if (st.step_outbits & st.raster_bit) {
+        raster_step();
+    }
+
+    // Ramp the laser power with the speed across the segment
+    if (st.exec_segment->spindle_dev_step) {
+        uint32_t dev_speed = st.spindle_dev_q >> 16;
+        st.spindle_dev_q += st.exec_segment->spindle_dev_step;
+        if ((st.spindle_dev_q >> 16) != dev_speed) {
+            spindle->setSpeedfromISR(st.spindle_dev_q >> 16);
+        }
+    }
+
     st.step_count--;  // Decrement step events count
     if (st.step_count == 0) {
         // Segment is complete. Discard current segment and advance segment indexing.
-        st.exec_segment     = NULL;
-        segment_buffer_tail = segment_buffer_tail >= (Stepping::_segments - 1) ? 0 : segment_buffer_tail + 1;
+        st.exec_segment = NULL;
+        segment_ring.pop();
+        uint32_t left = segment_ring.size();
+        if (left < isr_stats.low_water && prep_pending.load(std::memory_order_relaxed)) {
+            isr_stats.low_water = left;
+        }
+        if (left < prep_watermark && prepTask) {
+            vTaskNotifyGiveFromISR(prepTask, NULL);
+        }
     }
 
     Stepping::unstep();
@@ -285,6 +558,16 @@ void Stepper::wake_up() {
     Stepping::startTimer();
 }
 
+bool Stepper::resume_queued() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    prep_buffer();
+    if (!segment_ring.size()) {
+        return false;
+    }
+    wake_up();
+    return true;
+}
+
 void Stepper::go_idle() {
     awake = false;
     stop_stepping();
@@ -300,14 +583,14 @@ void Stepper::reset() {
 
     // Initialize stepper algorithm variables.
     memset(&prep, 0, sizeof(st_prep_t));
+    prep_pending = false;
     memset(&st, 0, sizeof(stepper_t));
+    st.exec_block_index = no_block;  // So the first segment loads its block, whatever its index
     st.exec_segment     = NULL;
     pl_block            = NULL;  // Planner block pointer used by segment buffer
-    segment_buffer_tail = 0;
-    segment_buffer_head = 0;  // empty = tail
-    segment_next_head   = 1;
-    st.step_outbits     = 0;
-    st.dir_outbits      = 0;  // Initialize direction bits to default.
+    segment_ring.clear();
+    st.step_outbits = 0;
+    st.dir_outbits  = 0;  // Initialize direction bits to default.
     // TODO do we need to turn step pins off?
 }
 
@@ -330,6 +613,10 @@ void Stepper::parking_setup_buffer() {
         prep.last_steps_remaining = prep.steps_remaining;
         prep.last_dt_remainder    = prep.dt_remainder;
         prep.last_step_per_mm     = prep.step_per_mm;
+#ifdef PREP_FIXED_POINT
+        prep.last_steps_remaining_q = prep.steps_remaining_q;
+        prep.last_dt_remainder_q    = prep.dt_remainder_q;
+#endif
     }
     // Set flags to execute a parking motion
     prep.recalculate_flag.parking     = 1;
@@ -349,6 +636,10 @@ void Stepper::parking_restore_buffer() {
         prep.recalculate_flag.holdPartialBlock = 1;
         prep.recalculate_flag.recalculate      = 1;
         prep.req_mm_increment                  = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;  // Recompute this value.
+#ifdef PREP_FIXED_POINT
+        prep.steps_remaining_q = prep.last_steps_remaining_q;
+        prep.dt_remainder_q    = prep.last_dt_remainder_q;
+#endif
     } else {
         prep.recalculate_flag = {};
     }
@@ -357,9 +648,218 @@ void Stepper::parking_restore_buffer() {
 }
 
 // Increments the step segment buffer block data ring buffer.
-static uint8_t next_block_index(uint8_t block_index) {
+static uint16_t next_block_index(uint16_t block_index) {
     block_index++;
-    return block_index == (Stepping::_segments - 1) ? 0 : block_index;
+    return block_index == st_blocks ? 0 : block_index;
+}
+
+// Finds the st_block_t for the next planner block. Returns false if it is still in use by the
+// oldest segment in the buffer, which happens when the buffer holds segments of st_blocks
+// different blocks, so prep has to wait for the step ISR to finish that segment.
+static bool next_st_block(uint16_t& index) {
+    index = next_block_index(prep.st_block_index);
+    if (prep.recalculate_flag.parking && prep.recalculate_flag.holdPartialBlock && index == prep.last_st_block_index) {
+        index = next_block_index(index);  // Keep the partly executed block for after the parking motion
+    }
+    const segment_t* oldest = segment_ring.oldest();
+    return !oldest || oldest->st_block_index != index;
+}
+
+void Stepper::set_low_latency(bool on) {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    low_latency    = on;
+    uint32_t depth = on ? std::min(Stepping::_lowLatencySegments, segment_depth_normal) : segment_depth_normal;
+    segment_ring.setDepth(depth);
+    prep_watermark = depth / 2;
+}
+
+uint32_t Stepper::segment_depth() {
+    return segment_ring.depth();
+}
+
+uint32_t Stepper::segment_blocks() {
+    return st_blocks;
+}
+
+#ifdef PREP_FIXED_POINT
+// Segment generator arithmetic for PREP_FIXED_POINT; see the units in st_prep_t. The
+// intermediate products fit in 64 bits for step rates up to 2^18 steps/sec and segment
+// times up to a few seconds.
+const int     Q_TIME_BITS            = 24;
+const int64_t REQ_MM_INCREMENT_Q     = int64_t(REQ_MM_INCREMENT_SCALAR * 65536);
+const int64_t TIMER_TICKS_PER_SECOND = Machine::Stepping::fStepperTimer;
+
+// Change in distance or speed over a time at a given speed or acceleration
+static inline int64_t q_over_time(int64_t rate, int64_t time) {
+    return (rate * time) >> Q_TIME_BITS;
+}
+
+// Time to cover a distance at a given average speed
+static inline int64_t q_time_for(int64_t distance, int64_t speed) {
+    return speed > 0 ? (distance << Q_TIME_BITS) / speed : 0;
+}
+
+// Converts the velocity profile that prep_buffer() has just computed in floating point to the
+// integer form used by the fixed-point segment generator. Called once per block, or when the
+// planner updates the executing block, so the per-segment work is all integer.
+static void prep_fixed_profile() {
+    float q_per_mm = prep.step_per_mm * 65536.0f;
+
+    // Rounding can put a profile point a hair beyond the exact distance remaining
+    auto distance = [q_per_mm](float mm) {
+        int64_t q = int64_t(mm * q_per_mm + 0.5f);
+        if (q < 0) {
+            return int64_t(0);
+        }
+        return q > prep.steps_remaining_q ? prep.steps_remaining_q : q;
+    };
+    prep.mm_complete_q      = distance(prep.mm_complete);
+    prep.accelerate_until_q = distance(prep.accelerate_until);
+    prep.decelerate_after_q = distance(prep.decelerate_after);
+
+    float q_per_mm_per_min = q_per_mm / 60.0f;
+    prep.current_speed_q   = int64_t(prep.current_speed * q_per_mm_per_min);
+    prep.maximum_speed_q   = int64_t(prep.maximum_speed * q_per_mm_per_min);
+    prep.exit_speed_q      = int64_t(prep.exit_speed * q_per_mm_per_min);
+    prep.acceleration_q    = int64_t(pl_block->acceleration * (q_per_mm / 3600.0f));
+
+    prep.q_to_mm         = 1.0f / q_per_mm;
+    prep.q_to_mm_per_min = 1.0f / q_per_mm_per_min;
+}
+#endif
+
+// Picks up the segment times from the stepping configuration.  Called at each new block so
+// that the times never change in the middle of a velocity profile.
+static void prep_segment_times() {
+    uint32_t ramp_ticks   = Stepping::_accelerationTicks;
+    uint32_t cruise_ticks = Stepping::_cruiseTicks;
+    if (low_latency && Stepping::_lowLatencyTicks > ramp_ticks) {
+        ramp_ticks   = Stepping::_lowLatencyTicks;
+        cruise_ticks = 0;
+    }
+    if (cruise_ticks == 0 || cruise_ticks > ramp_ticks) {
+        cruise_ticks = ramp_ticks;
+    }
+    prep.dt_ramp   = 1.0f / (float(ramp_ticks) * 60.0f);  // min/segment
+    prep.dt_cruise = 1.0f / (float(cruise_ticks) * 60.0f);
+#ifdef PREP_FIXED_POINT
+    prep.dt_ramp_q   = (int64_t(1) << Q_TIME_BITS) / ramp_ticks;
+    prep.dt_cruise_q = (int64_t(1) << Q_TIME_BITS) / cruise_ticks;
+#endif
+}
+
+// Computes the velocity profile of a block with a jerk limit. This is the counterpart of the
+// trapezoid calculation in prep_buffer(), with the ramp distances from SCurve.h in place of the
+// constant-acceleration formulas. A ramp starts and ends at zero acceleration, so when the
+// profile is recomputed in the middle of a ramp, as for a feed hold, the new ramp starts over
+// from the current speed.
+static void prep_scurve_profile() {
+    float acceleration = pl_block->acceleration;
+    float jerk         = pl_block->jerk;
+    float millimeters  = pl_block->millimeters;
+    float entry_speed  = sqrtf(pl_block->entry_speed_sqr);
+
+    prep.ramp_started = false;
+    if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
+        prep.ramp_type    = RAMP_DECEL;
+        prep.decel_target = 0.0f;
+        float decel_dist  = millimeters - scurve_ramp_distance(entry_speed, 0.0f, acceleration, jerk);
+        if (decel_dist < 0.0f) {
+            // Deceleration through entire planner block. End of feed hold is not in this block.
+            prep.ramp.start(entry_speed, 0.0f, acceleration, jerk);
+            prep.exit_speed = prep.ramp.speed(prep.ramp.timeAt(millimeters));
+        } else {
+            prep.mm_complete = decel_dist;  // End of feed hold.
+            prep.exit_speed  = 0.0f;
+        }
+        return;
+    }
+
+    // [Normal Operation]
+    prep.ramp_type        = RAMP_ACCEL;
+    prep.accelerate_until = millimeters;
+    if (sys.step_control.executeSysMotion) {
+        prep.exit_speed = 0.0f;  // Enforce stop at end of system motion.
+    } else {
+        prep.exit_speed = sqrtf(plan_get_exec_block_exit_speed_sqr());
+    }
+    prep.decel_target = prep.exit_speed;
+
+    float nominal_speed = plan_compute_profile_nominal_speed(pl_block);
+    if (entry_speed > nominal_speed) {  // Only occurs during override reductions.
+        prep.accelerate_until = millimeters - scurve_ramp_distance(entry_speed, nominal_speed, acceleration, jerk);
+        if (prep.accelerate_until <= 0.0f) {  // Deceleration-only.
+            prep.ramp_type    = RAMP_DECEL;
+            prep.decel_target = nominal_speed;
+            // The override block exit speed is wherever the ramp to the new nominal speed has got to.
+            prep.ramp.start(entry_speed, nominal_speed, acceleration, jerk);
+            prep.exit_speed                     = prep.ramp.speed(prep.ramp.timeAt(millimeters));
+            prep.recalculate_flag.decelOverride = 1;  // Flag to load next block as deceleration override.
+        } else {
+            // Decelerate to cruise or cruise-decelerate types. Guaranteed to intersect updated plan.
+            prep.decelerate_after = scurve_ramp_distance(prep.exit_speed, nominal_speed, acceleration, jerk);
+            prep.maximum_speed    = nominal_speed;
+            prep.ramp_type        = RAMP_DECEL_OVERRIDE;
+        }
+    } else if (prep.exit_speed > entry_speed && scurve_ramp_distance(entry_speed, prep.exit_speed, acceleration, jerk) >= millimeters) {
+        // Acceleration-only type
+        prep.accelerate_until = 0.0f;
+        prep.maximum_speed    = prep.exit_speed;
+    } else if (prep.exit_speed < entry_speed && scurve_ramp_distance(prep.exit_speed, entry_speed, acceleration, jerk) >= millimeters) {
+        // Deceleration-only type
+        prep.ramp_type = RAMP_DECEL;
+    } else {
+        float accelerate_dist = scurve_ramp_distance(entry_speed, nominal_speed, acceleration, jerk);
+        float decelerate_dist = scurve_ramp_distance(prep.exit_speed, nominal_speed, acceleration, jerk);
+        if (accelerate_dist + decelerate_dist < millimeters) {  // Trapezoid type
+            prep.maximum_speed    = nominal_speed;
+            prep.decelerate_after = decelerate_dist;
+            if (entry_speed == nominal_speed) {
+                // Cruise-deceleration or cruise-only type.
+                prep.ramp_type = RAMP_CRUISE;
+            } else {
+                // Full-trapezoid or acceleration-cruise types
+                prep.accelerate_until -= accelerate_dist;
+            }
+        } else {  // Triangle type
+            prep.maximum_speed = scurve_peak_speed(entry_speed, prep.exit_speed, nominal_speed, millimeters, acceleration, jerk);
+            prep.accelerate_until -= scurve_ramp_distance(entry_speed, prep.maximum_speed, acceleration, jerk);
+            prep.decelerate_after = prep.accelerate_until;
+        }
+    }
+}
+
+// Advances the S-curve ramp of the current ramp state by time_var, starting the ramp from the
+// current speed toward target_speed if it is new. Returns true if the ramp ends at end_mm before
+// that, with time_var reduced to the time that it took.
+static bool scurve_advance(float& time_var, float& mm_remaining, float target_speed, float end_mm) {
+    if (!prep.ramp_started) {
+        prep.ramp.start(prep.current_speed, target_speed, pl_block->acceleration, pl_block->jerk);
+        prep.ramp_time    = 0.0f;
+        prep.ramp_mm      = mm_remaining;
+        prep.ramp_started = true;
+    }
+
+    float t = prep.ramp_time + time_var;
+    if (t < prep.ramp.duration()) {
+        float mm = prep.ramp_mm - prep.ramp.distance(t);
+        if (mm > end_mm) {
+            mm_remaining       = mm;
+            prep.current_speed = prep.ramp.speed(t);
+            prep.ramp_time     = t;
+            return false;
+        }
+        // The ramp is cut short, as at the end of a feed hold block
+        t                  = prep.ramp.timeAt(prep.ramp_mm - end_mm);
+        prep.current_speed = prep.ramp.speed(t);
+    } else {
+        t                  = prep.ramp.duration();
+        prep.current_speed = target_speed;
+    }
+    time_var          = t > prep.ramp_time ? t - prep.ramp_time : 0.0f;
+    mm_remaining      = end_mm;
+    prep.ramp_started = false;
+    return true;
 }
 
 /* Prepares step segment buffer. Continuously called from main program.
@@ -376,12 +876,14 @@ static uint8_t next_block_index(uint8_t block_index) {
    NOTE: Computation units are in steps, millimeters, and minutes.
 */
 void Stepper::prep_buffer() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    BENCH_PROBE(PrepBuffer);
     // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
     if (sys.step_control.endMotion) {
         return;
     }
 
-    while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+    while (!segment_ring.full()) {  // Check if we need to fill the buffer.
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -392,8 +894,11 @@ void Stepper::prep_buffer() {
             }
 
             if (pl_block == NULL) {
+                prep_pending = false;
                 return;  // No planner blocks. Exit.
             }
+            prep_pending = true;
+            prep_line_number.store(pl_block->line_number, std::memory_order_relaxed);
 
             // Check if we need to only recompute the velocity profile or load a new block.
             if (prep.recalculate_flag.recalculate) {
@@ -404,7 +909,12 @@ void Stepper::prep_buffer() {
                 }
             } else {
                 // Load the Bresenham stepping data for the block.
-                prep.st_block_index = next_block_index(prep.st_block_index);
+                uint16_t index;
+                if (!next_st_block(index)) {
+                    pl_block = NULL;  // Load it again when the step ISR frees its st_block_t
+                    return;
+                }
+                prep.st_block_index = index;
                 // Prepare and copy Bresenham algorithm segment data from the new planner block, so that
                 // when the segment buffer completes the planner block, it may be discarded when the
                 // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
@@ -416,16 +926,35 @@ void Stepper::prep_buffer() {
                 // Bit-shift multiply all Bresenham data by the max AMASS level so that
                 // we never divide beyond the original data anywhere in the algorithm.
                 // If the original data is divided, we can lose a step from integer roundoff.
+                auto block_steps = &st_block_steps[prep.st_block_index * n_axis];
                 for (idx = 0; idx < n_axis; idx++) {
-                    st_prep_block->steps[idx] = pl_block->steps[idx] << maxAmassLevel;
+                    block_steps[idx] = pl_block->steps[idx] << maxAmassLevel;
                 }
                 st_prep_block->step_event_count = pl_block->step_event_count << maxAmassLevel;
 
+                // A scanline moves along one axis, the one that takes every step event
+                st_prep_block->raster_bit = 0;
+                if (pl_block->raster_pixels) {
+                    for (idx = 0; idx < n_axis; idx++) {
+                        if (pl_block->steps[idx] == pl_block->step_event_count) {
+                            st_prep_block->raster_bit = bitnum_to_mask(idx);
+                            break;
+                        }
+                    }
+                    st_prep_block->raster_pixels = pl_block->raster_pixels;
+                    st_prep_block->raster_first  = pl_block->raster_first;
+                }
+
                 // Initialize segment buffer data for generating the segments.
                 prep.steps_remaining  = (float)pl_block->step_event_count;
                 prep.step_per_mm      = prep.steps_remaining / pl_block->millimeters;
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;
                 prep.dt_remainder     = 0.0;  // Reset for new segment block
+                prep_segment_times();
+#ifdef PREP_FIXED_POINT
+                prep.steps_remaining_q = int64_t(pl_block->step_event_count) << 16;
+                prep.dt_remainder_q    = 0;
+#endif
                 if ((sys.step_control.executeHold) || prep.recalculate_flag.decelOverride) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed                  = prep.exit_speed;
@@ -437,12 +966,14 @@ void Stepper::prep_buffer() {
 
                 // prep.inv_rate is only used if is_pwm_rate_adjusted is true
                 st_prep_block->is_pwm_rate_adjusted = false;  // set default value
+                prep.ramp_power                     = false;
 
                 if (spindle->isRateAdjusted()) {
                     if (pl_block->spindle == SpindleState::Ccw) {
                         // Pre-compute inverse programmed rate to speed up PWM updating per step segment.
                         prep.inv_rate                       = 1.0f / pl_block->programmed_rate;
                         st_prep_block->is_pwm_rate_adjusted = true;
+                        prep.ramp_power                     = spindle->isPowerRamped() && !pl_block->raster_pixels;
                     }
                 }
             }
@@ -454,7 +985,9 @@ void Stepper::prep_buffer() {
             */
             prep.mm_complete  = 0.0;  // Default velocity profile complete at 0.0mm from end of block.
             float inv_2_accel = 0.5f / pl_block->acceleration;
-            if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
+            if (pl_block->jerk > 0.0f) {  // [Jerk-Limited Profile]
+                prep_scurve_profile();
+            } else if (sys.step_control.executeHold) {  // [Forced Deceleration to Zero Velocity]
                 // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
                 // the planner block profile, enforcing a deceleration to zero speed.
                 prep.ramp_type = RAMP_DECEL;
@@ -531,30 +1064,132 @@ void Stepper::prep_buffer() {
                 }
             }
 
+#ifdef PREP_FIXED_POINT
+            prep_fixed_profile();
+#endif
             sys.step_control.updateSpindleSpeed = true;  // Force update whenever updating block.
         }
 
         // Initialize new segment
-        volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+        segment_t* prep_segment = segment_ring.slot();
 
         // Set new segment to point to the current segment data block.
         prep_segment->st_block_index = prep.st_block_index;
 
+        float start_speed = prep.current_speed;  // Speed at the start of the segment, for laser power ramps
+
         /*------------------------------------------------------------------------------------
             Compute the average velocity of this new segment by determining the total distance
-          traveled over the segment time DT_SEGMENT. The following code first attempts to create
+          traveled over the segment time dt_ramp or dt_cruise. The following code first attempts to create
           a full segment based on the current ramp conditions. If the segment time is incomplete
           when terminating at a ramp state change, the code will continue to loop through the
           progressing ramp states to fill the remaining segment execution time. However, if
           an incomplete segment terminates at the end of the velocity profile, the segment is
-          considered completed despite having a truncated execution time less than DT_SEGMENT.
+          considered completed despite having a truncated execution time less than the segment time.
+            A segment that starts at cruise speed may be given the longer time dt_cruise; it is
+          cut short where the deceleration ramp begins, so the ramps are always traced with dt_ramp.
             The velocity profile is always assumed to progress through the ramp sequence:
           acceleration ramp, cruising state, and deceleration ramp. Each ramp's travel distance
           may range from zero to the length of the block. Velocity profiles can end either at
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
         */
-        float dt_max   = DT_SEGMENT;                                // Maximum segment time
+#ifdef PREP_FIXED_POINT
+        // The same ramp walk as below, in integer units
+        bool long_cruise = prep.ramp_type == RAMP_CRUISE && prep.dt_cruise_q > prep.dt_ramp_q;
+
+        int64_t dt_max      = long_cruise ? prep.dt_cruise_q : prep.dt_ramp_q;  // Maximum segment time
+        int64_t dt          = 0;                                 // Initialize segment time
+        int64_t time_var    = dt_max;                            // Time worker variable
+        int64_t q_var;                                           // Distance worker variable
+        int64_t speed_var;                                       // Speed worker variable
+        int64_t q_start     = prep.steps_remaining_q;            // Segment start distance from end of block.
+        int64_t q_remaining = q_start;                           // New segment distance from end of block.
+        int64_t minimum_q   = q_remaining - REQ_MM_INCREMENT_Q;  // Guarantee at least one step.
+
+        if (minimum_q < 0) {
+            minimum_q = 0;
+        }
+
+        do {
+            switch (prep.ramp_type) {
+                case RAMP_DECEL_OVERRIDE:
+                    speed_var = q_over_time(prep.acceleration_q, time_var);
+                    q_var     = q_over_time(prep.current_speed_q - speed_var / 2, time_var);
+                    q_remaining -= q_var;
+                    if ((q_remaining < prep.accelerate_until_q) || (q_var <= 0)) {
+                        q_remaining          = prep.accelerate_until_q;
+                        time_var             = q_time_for(2 * (q_start - q_remaining), prep.current_speed_q + prep.maximum_speed_q);
+                        prep.ramp_type       = RAMP_CRUISE;
+                        prep.current_speed_q = prep.maximum_speed_q;
+                    } else {
+                        prep.current_speed_q -= speed_var;
+                    }
+                    break;
+                case RAMP_ACCEL:
+                    speed_var = q_over_time(prep.acceleration_q, time_var);
+                    q_remaining -= q_over_time(prep.current_speed_q + speed_var / 2, time_var);
+                    if (q_remaining < prep.accelerate_until_q) {
+                        q_remaining = prep.accelerate_until_q;
+                        time_var    = q_time_for(2 * (q_start - q_remaining), prep.current_speed_q + prep.maximum_speed_q);
+                        if (q_remaining == prep.decelerate_after_q) {
+                            prep.ramp_type = RAMP_DECEL;
+                        } else {
+                            prep.ramp_type = RAMP_CRUISE;
+                        }
+                        prep.current_speed_q = prep.maximum_speed_q;
+                    } else {
+                        prep.current_speed_q += speed_var;
+                    }
+                    break;
+                case RAMP_CRUISE:
+                    q_var = q_remaining - q_over_time(prep.maximum_speed_q, time_var);
+                    if (q_var < prep.decelerate_after_q) {
+                        time_var       = q_time_for(q_remaining - prep.decelerate_after_q, prep.maximum_speed_q);
+                        q_remaining    = prep.decelerate_after_q;
+                        prep.ramp_type = RAMP_DECEL;
+                        if (long_cruise) {
+                            dt_max = dt + time_var;
+                        }
+                    } else {
+                        q_remaining = q_var;
+                    }
+                    break;
+                default:  // case RAMP_DECEL:
+                    speed_var = q_over_time(prep.acceleration_q, time_var);
+                    if (prep.current_speed_q > speed_var) {
+                        q_var = q_remaining - q_over_time(prep.current_speed_q - speed_var / 2, time_var);
+                        if (q_var > prep.mm_complete_q) {
+                            q_remaining = q_var;
+                            prep.current_speed_q -= speed_var;
+                            break;
+                        }
+                    }
+                    time_var             = q_time_for(2 * (q_remaining - prep.mm_complete_q), prep.current_speed_q + prep.exit_speed_q);
+                    q_remaining          = prep.mm_complete_q;
+                    prep.current_speed_q = prep.exit_speed_q;
+            }
+
+            dt += time_var;
+            if (dt < dt_max) {
+                time_var = dt_max - dt;
+            } else {
+                if (q_remaining > minimum_q) {
+                    dt_max += prep.dt_ramp_q;
+                    time_var = dt_max - dt;
+                } else {
+                    break;
+                }
+            }
+        } while (q_remaining > prep.mm_complete_q);
+
+        // For status reports, the laser power below and planner updates of the executing block
+        prep.current_speed = prep.current_speed_q * prep.q_to_mm_per_min;
+#else
+        // Segments that start at cruise speed may be longer than those in the ramps
+        bool long_cruise = prep.ramp_type == RAMP_CRUISE && prep.dt_cruise > prep.dt_ramp;
+
+        float dt_max   = long_cruise ? prep.dt_cruise : prep.dt_ramp;  // Maximum segment time
         float dt       = 0.0;                                       // Initialize segment time
         float time_var = dt_max;                                    // Time worker variable
         float mm_var;                                               // mm-Distance worker variable
@@ -569,6 +1204,12 @@ void Stepper::prep_buffer() {
         do {
             switch (prep.ramp_type) {
                 case RAMP_DECEL_OVERRIDE:
+                    if (pl_block->jerk > 0.0f) {
+                        if (scurve_advance(time_var, mm_remaining, prep.maximum_speed, prep.accelerate_until)) {
+                            prep.ramp_type = RAMP_CRUISE;
+                        }
+                        break;
+                    }
                     speed_var = pl_block->acceleration * time_var;
                     mm_var    = time_var * (prep.current_speed - 0.5f * speed_var);
                     mm_remaining -= mm_var;
@@ -584,6 +1225,16 @@ void Stepper::prep_buffer() {
                     break;
                 case RAMP_ACCEL:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
+                    if (pl_block->jerk > 0.0f) {
+                        if (scurve_advance(time_var, mm_remaining, prep.maximum_speed, prep.accelerate_until)) {
+                            if (mm_remaining == prep.decelerate_after) {
+                                prep.ramp_type = RAMP_DECEL;
+                            } else {
+                                prep.ramp_type = RAMP_CRUISE;
+                            }
+                        }
+                        break;
+                    }
                     speed_var = pl_block->acceleration * time_var;
                     mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
                     if (mm_remaining < prep.accelerate_until) {  // End of acceleration ramp.
@@ -610,11 +1261,18 @@ void Stepper::prep_buffer() {
                         time_var       = (mm_remaining - prep.decelerate_after) / prep.maximum_speed;
                         mm_remaining   = prep.decelerate_after;  // NOTE: 0.0 at EOB
                         prep.ramp_type = RAMP_DECEL;
+                        if (long_cruise) {
+                            dt_max = dt + time_var;  // End a long cruise segment where the deceleration ramp starts.
+                        }
                     } else {  // Cruising only.
                         mm_remaining = mm_var;
                     }
                     break;
                 default:  // case RAMP_DECEL:
+                    if (pl_block->jerk > 0.0f) {
+                        scurve_advance(time_var, mm_remaining, prep.decel_target, prep.mm_complete);
+                        break;
+                    }
                     // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
                     speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
                     if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
@@ -639,13 +1297,14 @@ void Stepper::prep_buffer() {
                 if (mm_remaining > minimum_mm) {  // Check for very slow segments with zero steps.
                     // Increase segment time to ensure at least one step in segment. Override and loop
                     // through distance calculations until minimum_mm or mm_complete.
-                    dt_max += DT_SEGMENT;
+                    dt_max += prep.dt_ramp;
                     time_var = dt_max - dt;
                 } else {
                     break;  // **Complete** Exit loop. Segment execution time maxed.
                 }
             }
         } while (mm_remaining > prep.mm_complete);  // **Complete** Exit loop. Profile complete.
+#endif
 
         /* -----------------------------------------------------------------------------------
           Compute spindle speed PWM output for step segment
@@ -669,8 +1328,14 @@ void Stepper::prep_buffer() {
             }
             sys.step_control.updateSpindleSpeed = false;
         }
-        prep_segment->spindle_speed     = prep.current_spindle_speed;
+        // With a power ramp, the segment starts at the power for its start speed and the ISR
+        // steps it to the power for its end speed, instead of holding the end power throughout.
+        uint32_t start_dev_speed = 0;
+        if (prep.ramp_power && pl_block->spindle != SpindleState::Disable) {
+            start_dev_speed = spindle->mapSpeed(pl_block->spindle, pl_block->spindle_speed * start_speed * prep.inv_rate);
+        }
         prep_segment->spindle_dev_speed = spindle->mapSpeed(pl_block->spindle, prep.current_spindle_speed);  // Reload segment PWM value
+        prep_segment->spindle_dev_step  = 0;
 
         /* -----------------------------------------------------------------------------------
            Compute segment step rate, steps to execute, and apply necessary rate corrections.
@@ -682,10 +1347,23 @@ void Stepper::prep_buffer() {
            Fortunately, this scenario is highly unlikely and unrealistic in typical DIY CNC
            machines (i.e. exceeding 10 meters axis travel at 200 step/mm).
         */
-        float step_dist_remaining    = prep.step_per_mm * mm_remaining;                       // Convert mm_remaining to steps
-        float n_steps_remaining      = ceilf(step_dist_remaining);                            // Round-up current steps remaining
-        float last_n_steps_remaining = ceilf(prep.steps_remaining);                           // Round-up last steps remaining
-        prep_segment->n_step         = uint16_t(last_n_steps_remaining - n_steps_remaining);  // Compute number of steps to execute.
+#ifdef PREP_FIXED_POINT
+        int64_t n_steps_remaining      = (q_remaining + 0xffff) >> 16;                // Round-up current steps remaining
+        int64_t last_n_steps_remaining = (prep.steps_remaining_q + 0xffff) >> 16;     // Round-up last steps remaining
+        int64_t n_step                 = last_n_steps_remaining - n_steps_remaining;  // Compute number of steps to execute.
+#else
+        float step_dist_remaining    = prep.step_per_mm * mm_remaining;             // Convert mm_remaining to steps
+        float n_steps_remaining      = ceilf(step_dist_remaining);                  // Round-up current steps remaining
+        float last_n_steps_remaining = ceilf(prep.steps_remaining);                 // Round-up last steps remaining
+        float n_step                 = last_n_steps_remaining - n_steps_remaining;  // Compute number of steps to execute.
+#endif
+        if (n_step > max_segment_steps) {
+            // Truncating would lose steps silently
+            log_error("Step segment of " << uint64_t(n_step) << " steps is too long");
+            mc_critical(ExecAlarm::AbortCycle);
+            return;
+        }
+        prep_segment->n_step = uint32_t(n_step);
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
         if (prep_segment->n_step == 0) {
@@ -693,6 +1371,7 @@ void Stepper::prep_buffer() {
                 // Less than one step to decelerate to zero speed, but already very close. AMASS
                 // requires full steps to execute. So, just bail.
                 sys.step_control.endMotion = true;
+                prep_pending               = false;
                 if (!(prep.recalculate_flag.parking)) {
                     prep.recalculate_flag.holdPartialBlock = 1;
                 }
@@ -709,6 +1388,23 @@ void Stepper::prep_buffer() {
         // typically very small and do not adversely effect performance, but ensures that the
         // system outputs the exact acceleration and velocity profiles computed by the planner.
 
+#ifdef PREP_FIXED_POINT
+        dt += prep.dt_remainder_q;  // Apply previous segment partial step execute time
+
+        // Steps to execute, including the partial step carried over from the previous segment.
+        // dt is in 1/2^24 sec and step_q in 1/65536 steps, so dt * fStepperTimer / (step_q << 8)
+        // is in timerTicks/step.
+        int64_t  step_q         = (last_n_steps_remaining << 16) - q_remaining;
+        uint32_t timerTicks     = 0xffffffff;
+        int64_t  dt_remainder_q = 0;
+        if (step_q > 0) {
+            int64_t ticks = (dt * TIMER_TICKS_PER_SECOND + (step_q << 8) - 1) / (step_q << 8);  // Round up
+            if (ticks < 0xffffffff) {
+                timerTicks = uint32_t(ticks);
+            }
+            dt_remainder_q = ((n_steps_remaining << 16) - q_remaining) * dt / step_q;
+        }
+#else
         dt += prep.dt_remainder;  // Apply previous segment partial step execute time
         // dt is in minutes so inv_rate is in minutes
         float inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
@@ -717,7 +1413,8 @@ void Stepper::prep_buffer() {
         // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
         // timerTicks/sec * 60 sec/minute * minutes = timerTicks
         uint32_t timerTicks = uint32_t(ceilf((Machine::Stepping::fStepperTimer * 60) * inv_rate));  // (timerTicks/step)
-        int      level;
+#endif
+        int level;
 
         // Compute step timing and multi-axis smoothing level.
         for (level = 0; level < maxAmassLevel; level++) {
@@ -728,27 +1425,47 @@ void Stepper::prep_buffer() {
         }
         prep_segment->amass_level = level;
         prep_segment->n_step <<= level;
+
+        // Spread the power change evenly over the ISR ticks, which are evenly spaced in time, so
+        // the power tracks the speed through the ramp. With at least two ticks, the step fits.
+        if (prep.ramp_power && prep_segment->n_step > 1 && start_dev_speed != prep_segment->spindle_dev_speed) {
+            int64_t change                  = int64_t(prep_segment->spindle_dev_speed) - int64_t(start_dev_speed);
+            prep_segment->spindle_dev_step  = change * 65536 / prep_segment->n_step;
+            prep_segment->spindle_dev_speed = start_dev_speed;
+        }
         // isrPeriod is stored as 16 bits, so limit timerTicks to the
         // largest value that will fit in a uint16_t.
         prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
 
         // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        auto lastseg        = segment_next_head;
-        segment_next_head   = segment_next_head >= (Stepping::_segments - 1) ? 0 : segment_next_head + 1;
-        segment_buffer_head = lastseg;
+        segment_ring.push();
+        BENCH_ITEMS(1);
 
         // Update the appropriate planner and segment data.
+#ifdef PREP_FIXED_POINT
+        pl_block->millimeters  = q_remaining * prep.q_to_mm;
+        prep.steps_remaining_q = q_remaining;
+        prep.dt_remainder_q    = dt_remainder_q;
+
+        bool profile_complete = q_remaining == prep.mm_complete_q;
+        bool distance_left    = q_remaining > 0;
+#else
         pl_block->millimeters = mm_remaining;
         prep.steps_remaining  = n_steps_remaining;
         prep.dt_remainder     = (n_steps_remaining - step_dist_remaining) * inv_rate;
+
+        bool profile_complete = mm_remaining == prep.mm_complete;
+        bool distance_left    = mm_remaining > 0.0;
+#endif
         // Check for exit conditions and flag to load next planner block.
-        if (mm_remaining == prep.mm_complete) {
+        if (profile_complete) {
             // End of planner block or forced-termination. No more distance to be executed.
-            if (mm_remaining > 0.0) {  // At end of forced-termination.
+            if (distance_left) {  // At end of forced-termination.
                 // Reset prep parameters for resuming and then bail. Allow the stepper ISR to complete
                 // the segment queue, where realtime protocol will set new state upon receiving the
                 // cycle stop flag from the ISR. Prep_segment is blocked until then.
                 sys.step_control.endMotion = true;
+                prep_pending               = false;
                 if (!(prep.recalculate_flag.parking)) {
                     prep.recalculate_flag.holdPartialBlock = 1;
                 }
@@ -757,10 +1474,12 @@ void Stepper::prep_buffer() {
                 // The planner block is complete. All steps are set to be executed in the segment buffer.
                 if (sys.step_control.executeSysMotion) {
                     sys.step_control.endMotion = true;
+                    prep_pending               = false;
                     return;
                 }
                 pl_block = NULL;  // Set pointer to indicate check and load next planner block.
                 plan_discard_current_block();
+                prep_pending = plan_get_current_block() != NULL;
             }
         }
     }
@@ -12,6 +12,7 @@
 #include "EnumItem.h"
 
 #include <cstdint>
+#include <mutex>
 
 namespace Stepper {
     void init();
@@ -21,6 +22,10 @@ namespace Stepper {
     // Enable steppers, but cycle does not start unless called by motion control or realtime command.
     void wake_up();
 
+    // Restarts stepping if the segment buffer has segments, or prep can make some, after the step ISR
+    // found it empty and stopped. Returns true if stepping restarted.
+    bool resume_queued();
+
     // Stops stepping and disables stepper (not ISR-safe)
     void go_idle();
 
@@ -36,14 +41,59 @@ namespace Stepper {
     // Restores the step segment buffer to the normal run state after a parking motion.
     void parking_restore_buffer();
 
-    // Reloads step segment buffer. Called continuously by realtime execution system.
+    // Limits the segment buffer to Stepping::_lowLatencySegments shorter segments while on, for
+    // homing and probing. Takes effect for the segments of the next planner block.
+    void set_low_latency(bool on);
+
+    // Reloads step segment buffer. Called continuously by realtime execution system, and by the
+    // prep task when the step ISR drains the buffer below its watermark.
     void prep_buffer();
 
+    // Held by prep_buffer(). Foreground code that changes the planner buffer, the segment prep
+    // state or sys.step_control holds it too, so the prep task cannot refill the buffer part way
+    // through the change.
+    extern std::recursive_mutex prep_mutex;
+
     // Called by planner_recalculate() when the executing block is updated by the new plan.
     bool update_plan_block_parameters();
 
     // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
     float get_realtime_rate();
 
-    extern uint32_t isr_count;
+    // Number of segments the step segment buffer holds, and of entries in the pool of
+    // planner block step data that the segments refer to, as sized by init()
+    uint32_t segment_depth();
+    uint32_t segment_blocks();
+
+    // Step ISR timing, always collected.  Durations are in CPU cycles.
+    struct isr_stats_t {
+        uint32_t count;         // Calls of pulse_func()
+        uint32_t min_cycles;    // Shortest call
+        uint32_t max_cycles;    // Longest call
+        uint64_t total_cycles;  // Sum of all calls, for the average
+        uint32_t late;          // Calls that outlasted the step timer period, delaying the next one
+        uint32_t low_water;     // Fewest segments left in the buffer when one finished while prep had more
+    };
+    extern isr_stats_t isr_stats;
+
+    void reset_isr_stats();
+
+    // Segment buffer underruns, when the step ISR found the buffer empty while prep still had steps
+    // of a planner block to generate, so the machine stalled mid-motion.
+    struct underrun_t {
+        int32_t  line_number;  // Line number of the starved planner block
+        uint32_t usecs;        // How long the stall lasted
+    };
+    struct underrun_stats_t {
+        static const int LOG_SIZE = 16;
+
+        uint32_t   count;
+        uint64_t   total_usecs;
+        uint32_t   max_usecs;      // Longest underrun
+        int32_t    max_line;       // Line number of the longest underrun
+        underrun_t log[LOG_SIZE];  // The most recent underruns, with the next at log[count % LOG_SIZE]
+    };
+    extern underrun_stats_t underrun_stats;
+
+    void reset_underrun_stats();
 }
@@ -8,6 +8,11 @@
 step_engine_t* step_engines = NULL;  // Linked list of stepping engines
 
 step_engine_t* find_engine(const char* name) {
+    for (step_engine_t* p = step_engines; p; p = p->link) {
+        if (strcmp(name, p->name) == 0) {
+            return p;
+        }
+    }
     for (step_engine_t* p = step_engines; p; p = p->link) {
         // Initial substring match, handles different forms of I2S
         if (strncmp(name, p->name, strlen(p->name)) == 0) {
@@ -22,12 +27,24 @@ namespace Machine {
     // fStepperTimer should be an integer divisor of the bus speed, i.e. of fTimers
     const int ticksPerMicrosecond = Stepping::fStepperTimer / 1000000;
 
+#ifdef STM32
+    int Stepping::_engine = DMA_ENGINE;
+#else
     int Stepping::_engine = RMT_ENGINE;
+#endif
 
     AxisMask Stepping::direction_mask = 0;
 
-    bool   Stepping::_switchedStepper = false;
-    size_t Stepping::_segments        = 12;
+    bool     Stepping::_switchedStepper  = false;
+    uint32_t Stepping::_segments         = 12;
+    uint32_t Stepping::_segmentBlocks    = 0;
+    uint32_t Stepping::_holdLatencyMsecs = 0;
+
+    uint32_t Stepping::_accelerationTicks = ACCELERATION_TICKS_PER_SECOND;
+    uint32_t Stepping::_cruiseTicks       = 0;
+
+    uint32_t Stepping::_lowLatencySegments = 4;
+    uint32_t Stepping::_lowLatencyTicks    = 2 * ACCELERATION_TICKS_PER_SECOND;
 
     uint32_t Stepping::_idleMsecs           = 255;
     uint32_t Stepping::_pulseUsecs          = 4;
@@ -40,13 +57,15 @@ namespace Machine {
                                    { Stepping::RMT_ENGINE, "RMT" },
                                    { Stepping::I2S_STATIC, "I2S_STATIC" },
                                    { Stepping::I2S_STREAM, "I2S_STREAM" },
+                                   { Stepping::DMA_ENGINE, "DMA" },
+                                   { Stepping::I2S_DMA, "I2S_DMA" },
                                    EnumItem(Stepping::RMT_ENGINE) };
 
     void Stepping::afterParse() {
         const char* name = stepTypes[_engine].name;
         step_engine      = find_engine(name);
         Assert(step_engine, "Cannot find stepping engine for %s", name);
-        Assert(strcmp("I2S", name) || config->_i2so, "I2SO bus must be configured for this stepping type");
+        Assert(strncmp("I2S", name, 3) || config->_i2so, "I2SO bus must be configured for this stepping type");
     }
 
     void Stepping::init() {
@@ -69,6 +88,14 @@ namespace Machine {
 
 Stepping::motor_t* Stepping::axis_motors[MAX_N_AXIS][MAX_MOTORS_PER_AXIS] = { nullptr };
 
+bool                  Stepping::step_masks        = false;
+uint32_t              Stepping::step_table[1 << MAX_N_AXIS];
+uint32_t              Stepping::step_invert_bits  = 0;
+uint32_t              Stepping::step_all_bits     = 0;
+int                   Stepping::step_bit_pins[32] = { 0 };
+uint32_t              Stepping::step_blocked_bits = 0;
+std::atomic<uint32_t> Stepping::step_limited_bits { 0 };
+
 void Stepping::assignMotor(int axis, int motor, int step_pin, bool step_invert, int dir_pin, bool dir_invert) {
     step_pin = step_engine->init_step_pin(step_pin, step_invert);
 
@@ -78,45 +105,97 @@ void Stepping::assignMotor(int axis, int motor, int step_pin, bool step_invert,
     m->step_invert           = step_invert;
     m->dir_pin               = dir_pin;
     m->dir_invert            = dir_invert;
-    m->blocked               = false;
-    m->limited               = false;
 
     if (motor == 0 && dir_invert) {
         set_bitnum(direction_mask, axis);
     }
+
+    compileStepMasks();
 }
 
-int Stepping::axis_steps[MAX_N_AXIS] = { 0 };
+// Assigns each motor its step bit and rebuilds the step masks.  The engine's own pin
+// numbers are used as the bits when it can take them, so step() can pass the masks
+// straight through.
+void Stepping::compileStepMasks() {
+    step_masks = step_engine->write_step_pins != nullptr;
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
+            auto m = axis_motors[axis][motor];
+            if (m && (m->step_pin < 0 || m->step_pin > 31)) {
+                step_masks = false;
+            }
+        }
+    }
 
-bool* Stepping::limit_var(int axis, int motor) {
-    auto m = axis_motors[axis][motor];
-    return m ? &(m->limited) : nullptr;
+    uint32_t axis_bits[MAX_N_AXIS] = { 0 };
+    int      next_bit              = 0;
+    step_invert_bits               = 0;
+    step_all_bits                  = 0;
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
+            auto m = axis_motors[axis][motor];
+            if (m) {
+                int bit            = step_masks ? m->step_pin : next_bit++;
+                m->step_bit        = uint32_t(1) << bit;
+                step_bit_pins[bit] = m->step_pin;
+                axis_bits[axis] |= m->step_bit;
+                step_all_bits |= m->step_bit;
+                if (m->step_invert) {
+                    step_invert_bits |= m->step_bit;
+                }
+            }
+        }
+    }
+
+    for (uint32_t axes = 0; axes < (1 << MAX_N_AXIS); axes++) {
+        step_table[axes] = 0;
+        for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+            if (bitnum_is_true(axes, axis)) {
+                step_table[axes] |= axis_bits[axis];
+            }
+        }
+    }
 }
 
+int Stepping::axis_steps[MAX_N_AXIS] = { 0 };
+
 void Stepping::block(int axis, int motor) {
     auto m = axis_motors[axis][motor];
     if (m) {
-        m->blocked = true;
+        step_blocked_bits |= m->step_bit;
     }
 }
 
 void Stepping::unblock(int axis, int motor) {
     auto m = axis_motors[axis][motor];
     if (m) {
-        m->blocked = false;
+        step_blocked_bits &= ~m->step_bit;
     }
 }
 
-void Stepping::limit(int axis, int motor) {
+void IRAM_ATTR Stepping::limit(int axis, int motor) {
     auto m = axis_motors[axis][motor];
     if (m) {
-        m->limited = true;
+        step_limited_bits.fetch_or(m->step_bit, std::memory_order_relaxed);
     }
 }
-void Stepping::unlimit(int axis, int motor) {
+void IRAM_ATTR Stepping::unlimit(int axis, int motor) {
     auto m = axis_motors[axis][motor];
     if (m) {
-        m->limited = false;
+        step_limited_bits.fetch_and(~m->step_bit, std::memory_order_relaxed);
+    }
+}
+
+// Sets the step pins in the mask to the corresponding levels
+static inline void IRAM_ATTR write_step_pins(step_engine_t* engine, bool masks, const int* bit_pins, uint32_t pins, uint32_t levels) {
+    if (masks) {
+        engine->write_step_pins(pins, levels);
+        return;
+    }
+    while (pins) {
+        int bit = __builtin_ctz(pins);
+        pins &= pins - 1;
+        engine->set_step_pin(bit_pins[bit], (levels >> bit) & 1);
     }
 }
 
@@ -149,18 +228,17 @@ void IRAM_ATTR Stepping::step(uint8_t step_mask, uint8_t dir_mask) {
 
     step_engine->start_step();
 
+    // Count the steps
+    for (uint32_t axes = step_mask; axes; axes &= axes - 1) {
+        int axis = __builtin_ctz(axes);
+        axis_steps[axis] += bitnum_is_true(dir_mask, axis) ? -1 : 1;
+    }
+
     // Turn on step pulses for motors that are supposed to step now
-    for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
-        if (bitnum_is_true(step_mask, axis)) {
-            auto increment = bitnum_is_true(dir_mask, axis) ? -1 : 1;
-            axis_steps[axis] += increment;
-            for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
-                auto m = axis_motors[axis][motor];
-                if (m && !m->blocked && !m->limited) {
-                    step_engine->set_step_pin(m->step_pin, !m->step_invert);
-                }
-            }
-        }
+    uint32_t pins = step_table[step_mask & ((1 << MAX_N_AXIS) - 1)];
+    pins &= ~(step_blocked_bits | step_limited_bits.load(std::memory_order_relaxed));
+    if (pins) {
+        write_step_pins(step_engine, step_masks, step_bit_pins, pins, ~step_invert_bits);
     }
     step_engine->finish_step();
 }
@@ -170,20 +248,23 @@ void IRAM_ATTR Stepping::unstep() {
     if (step_engine->start_unstep()) {
         return;
     }
-    for (size_t axis = 0; axis < Axes::_numberAxis; axis++) {
-        for (size_t motor = 0; motor < MAX_MOTORS_PER_AXIS; motor++) {
-            auto m = axis_motors[axis][motor];
-            if (m) {
-                step_engine->set_step_pin(m->step_pin, m->step_invert);
-            }
-        }
-    }
+    write_step_pins(step_engine, step_masks, step_bit_pins, step_all_bits, step_invert_bits);
     step_engine->finish_unstep();
 }
 
 void Stepping::reset() {}
-void Stepping::beginLowLatency() {}
-void Stepping::endLowLatency() {}
+void Stepping::beginLowLatency() {
+    if (step_engine->set_low_latency) {
+        step_engine->set_low_latency(true);
+    }
+    Stepper::set_low_latency(true);
+}
+void Stepping::endLowLatency() {
+    Stepper::set_low_latency(false);
+    if (step_engine->set_low_latency) {
+        step_engine->set_low_latency(false);
+    }
+}
 
 // Called only from Stepper::pulse_func when a new segment is loaded
 // The argument is in units of ticks of the timer that generates ISRs
@@ -207,9 +288,19 @@ void Stepping::group(Configuration::HandlerBase& handler) {
     handler.item("pulse_us", _pulseUsecs, 0, 30);
     handler.item("dir_delay_us", _directionDelayUsecs, 0, 10);
     handler.item("disable_delay_us", _disableDelayUsecs, 0, 1000000);  // max 1 second
-    handler.item("segments", _segments, 6, 20);
+    handler.item("segments", _segments, 6, 1024);
+    handler.item("segment_blocks", _segmentBlocks, 0, 1024);      // 0 means one per segment, 1 means 2
+    handler.item("hold_latency_ms", _holdLatencyMsecs, 0, 1000);  // 0 means use segments
+    handler.item("acceleration_ticks_per_sec", _accelerationTicks, 20, 1000);
+    handler.item("cruise_ticks_per_sec", _cruiseTicks, 0, 1000);  // 0 means same as acceleration_ticks_per_sec
+    handler.item("low_latency_segments", _lowLatencySegments, 2, 1024);
+    handler.item("low_latency_ticks_per_sec", _lowLatencyTicks, 0, 1000);  // 0 means same as acceleration_ticks_per_sec
 }
 
 uint32_t Stepping::maxPulsesPerSec() {
     return step_engine->max_pulses_per_sec();
 }
+
+uint32_t Stepping::engineUnderruns() {
+    return step_engine->underruns ? step_engine->underruns() : 0;
+}
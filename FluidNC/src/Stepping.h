@@ -7,6 +7,8 @@
 #include "Configuration/Configurable.h"
 #include "Driver/step_engine.h"
 
+#include <atomic>
+
 namespace Machine {
     class Stepping : public Configuration::Configurable {
     public:
@@ -19,16 +21,28 @@ namespace Machine {
 
         static const int MAX_MOTORS_PER_AXIS = 2;
         struct motor_t {
-            int  step_pin;
-            int  dir_pin;
-            bool step_invert;
-            bool dir_invert;
-            bool blocked;
-            bool limited;
+            int      step_pin;
+            int      dir_pin;
+            bool     step_invert;
+            bool     dir_invert;
+            uint32_t step_bit;  // Bit for the step pin in the compiled step masks
         };
         static motor_t* axis_motors[MAX_N_AXIS][MAX_MOTORS_PER_AXIS];
         static int      _n_active_axes;
 
+        // The motor configuration compiled into step pin masks, so a step pulse is a table
+        // lookup and one write_step_pins() call instead of a walk over every motor.  When the
+        // engine takes pin masks, a bit number is the number that init_step_pin() returned;
+        // otherwise bits are handed out in order and step_bit_pins maps them back.
+        static bool                  step_masks;                   // The engine writes whole pin masks
+        static uint32_t              step_table[1 << MAX_N_AXIS];  // Step pins of the axes in each axis mask
+        static uint32_t              step_invert_bits;             // Step pins that are active low
+        static uint32_t              step_all_bits;                // All step pins
+        static int                   step_bit_pins[32];            // Engine pin number for each bit
+        static uint32_t              step_blocked_bits;            // Motors stopped during ganged homing
+        static std::atomic<uint32_t> step_limited_bits;            // Motors stopped by their limit switches
+        static void                  compileStepMasks();
+
         static void    startPulseTimer();
         static void    waitDirection();  // Wait for direction delay
         static int32_t axis_steps[MAX_N_AXIS];
@@ -41,18 +55,42 @@ namespace Machine {
             RMT_ENGINE,
             I2S_STATIC,
             I2S_STREAM,
+            DMA_ENGINE,
+            I2S_DMA,
         };
 
         Stepping() = default;
 
         // _segments is the number of entries in the step segment buffer between the step execution algorithm
         // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
-        // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
+        // fixed time defined by _accelerationTicks. They are computed such that the planner
         // block velocity profile is traced exactly. The size of this buffer governs how much step
         // execution lead time there is for other processes to run.  The latency for a feedhold or other
-        // override is roughly 10 ms times _segments.
-
-        static size_t _segments;
+        // override is roughly the segment time times _segments, 10 ms times _segments by default.
+        // If _holdLatencyMsecs is nonzero, it sets _segments instead, to the number of segments
+        // that last that long, so the buffer is as deep as the tolerable feedhold latency allows.
+        //
+        // Each segment refers to the step data of its planner block in a separate pool of
+        // _segmentBlocks entries, one per segment if it is 0, and never fewer than 2.  A smaller
+        // pool saves RAM with a deep buffer, at the cost of stalling segment preparation when the
+        // buffer holds segments of that many different blocks, as it can with many short lines.
+
+        static uint32_t _segments;
+        static uint32_t _segmentBlocks;
+        static uint32_t _holdLatencyMsecs;
+
+        // Segments are 1/_accelerationTicks seconds long.  If _cruiseTicks is nonzero and lower,
+        // segments that start at cruise speed are 1/_cruiseTicks seconds long instead, ending early
+        // where deceleration begins.  Short segments trace the acceleration ramps more closely at
+        // the cost of more segment preparation; long cruise segments recover that cost.
+        static uint32_t _accelerationTicks;
+        static uint32_t _cruiseTicks;
+
+        // Between beginLowLatency() and endLowLatency(), for homing and probing, the segment buffer
+        // holds at most _lowLatencySegments segments of 1/_lowLatencyTicks seconds, so a switch
+        // stops the motion after less buffered travel.  _lowLatencyTicks of 0 keeps the segment time.
+        static uint32_t _lowLatencySegments;
+        static uint32_t _lowLatencyTicks;
 
         static uint32_t _idleMsecs;
         static uint32_t _pulseUsecs;
@@ -76,16 +114,16 @@ namespace Machine {
         static void step(uint8_t step_mask, uint8_t dir_mask);
         static void unstep();
 
-        // Used to stop a motor quickly when a limit switch is hit
-        static bool* limit_var(int axis, int motor);
-        static void  limit(int axis, int motor);
-        static void  unlimit(int axis, int motor);
+        // Used to stop a motor quickly when a limit switch is hit.  Safe to call from an ISR.
+        static void limit(int axis, int motor);
+        static void unlimit(int axis, int motor);
 
         // Used to stop a motor during ganged homint
         static void block(int axis, int motor);
         static void unblock(int axis, int motor);
 
         static uint32_t maxPulsesPerSec();
+        static uint32_t engineUnderruns();  // 0 if the engine does not count them
 
         static AxisMask direction_mask;
 
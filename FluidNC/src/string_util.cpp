@@ -22,6 +22,15 @@ namespace string_util {
         return std::equal(a.begin(), a.begin() + b.size(), b.begin(), b.end(), [](auto a, auto b) { return tolower(a) == tolower(b); });
     }
 
+    size_t hash_ignore_case::operator()(std::string_view s) const {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (auto c : s) {
+            hash = (hash ^ uint8_t(tolower(c))) * 16777619u;
+        }
+        return hash;
+    }
+
     // cppcheck-suppress unusedFunction
     const std::string_view trim(std::string_view s) {
         auto start = s.find_first_not_of(" \t\n\r\f\v");
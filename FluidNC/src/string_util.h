@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 
@@ -16,4 +17,12 @@ namespace string_util {
     bool from_float(std::string_view str, float& value);
     bool split(std::string_view& input, std::string_view& next, char delim);
     bool split_prefix(std::string_view& rest, std::string_view& prefix, char delim);
+
+    // For unordered containers of names that can be written in either case
+    struct hash_ignore_case {
+        size_t operator()(std::string_view s) const;
+    };
+    struct equal_to_ignore_case {
+        bool operator()(std::string_view a, std::string_view b) const { return equal_ignore_case(a, b); }
+    };
 }
@@ -0,0 +1,3 @@
+const char* grbl_version = "3.0";
+const char* git_info     = "v3.0.x (master-c48d86e-dirty)";
+const char* git_url      = "None";
@@ -46,7 +46,7 @@ void stepTimerInit(uint32_t frequency, bool (*fn)(void)) {
     if (step_timer) {
         step_timer->setOverflow(frequency, HERTZ_FORMAT);
         step_timer->attachInterrupt(stepTimerISR);
-        step_timer->resume();
+        // stepTimerStart() starts it, so that stepTimerStop() can stop it
     }
 }
 
@@ -1,93 +1,249 @@
 // Copyright (c) 2024 - FluidNC Contributors
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
+// Stepping engine for the STM32F4 that ends the step pulses with DMA.
+//
+// The step timer ISR runs pulse_func(), which starts the pulses with one write
+// to the BSRR register of each GPIO port that has step pins.  finish_step() then
+// starts TIM8 in one-pulse mode.  When TIM8 has counted the pulse length, its
+// compare channels request DMA2 transfers that write the BSRR words that end
+// the pulses, one DMA stream per port, so the end of the pulse needs neither a
+// spin loop nor another interrupt.  The streams run in circular mode with a
+// one-word buffer, so they stay armed from one pulse to the next and the CPU
+// only has to update the words.
+//
+// TIM8_CH1..CH4 request DMA2 streams 2, 3, 4 and 7 on channel 7.  DMA1 cannot
+// reach the GPIO ports on the F4, so the step pins can be on up to four ports.
+
 #include "Driver/step_engine.h"
+#include "Driver/StepTimer.h"
 #include "platform.h"
 
 #ifdef STM32
 
-#include <Arduino.h>
-#include "Driver/StepTimer.h"
+#    include <Arduino.h>
+#    include "src/Logging.h"
+
+static const int max_ports     = 4;
+static const int max_step_pins = 32;
+
+// TIM8 counts at about this rate while it times a pulse
+static const uint32_t pulse_timer_hz = 10000000;
+
+struct dma_port_t {
+    DMA_Stream_TypeDef* stream;
+    uint32_t            cc_dma_enable;  // TIM8 DIER bit that lets the compare channel request the stream
+    volatile uint32_t*  flag_clear;     // DMA2 interrupt flag clear register for the stream
+    uint32_t            flag_bits;
+};
+
+// The interrupt flags of a stream are FEIF, DMEIF, TEIF, HTIF and TCIF, at bits 0 and 2-5 of its field
+static const uint32_t stream_flags = 0x3d;
+
+static const dma_port_t dma_ports[max_ports] = {
+    { DMA2_Stream2, TIM_DIER_CC1DE, &DMA2->LIFCR, stream_flags << 16 },
+    { DMA2_Stream3, TIM_DIER_CC2DE, &DMA2->LIFCR, stream_flags << 22 },
+    { DMA2_Stream4, TIM_DIER_CC3DE, &DMA2->HIFCR, stream_flags << 0 },
+    { DMA2_Stream7, TIM_DIER_CC4DE, &DMA2->HIFCR, stream_flags << 22 },
+};
+
+static GPIO_TypeDef*     port_gpio[max_ports];
+static volatile uint32_t port_pulse[max_ports];  // BSRR word that starts the pulses of the current step
+static volatile uint32_t port_end[max_ports];    // BSRR word that the DMA writes to end them
+static int               n_ports = 0;
+
+// The step pin numbers that init_step_pin() returns index these
+static uint8_t  pin_port[max_step_pins];
+static uint32_t pin_mask[max_step_pins];  // BSRR bit that drives the pin high; the one 16 above drives it low
+static int      n_step_pins = 0;
+
+static uint32_t _dir_delay_us;
+static uint32_t _pulse_us;
+
+static uint32_t pulse_timer_clock() {
+    // The timers on APB2 run at twice the bus clock unless the bus is undivided
+    uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE2) == RCC_CFGR_PPRE2_DIV1 ? pclk2 : 2 * pclk2;
+}
 
-// STM32 step engine implementation
-// This provides the interface for generating step pulses
+static uint32_t init_engine(uint32_t dir_delay_us, uint32_t pulse_us, uint32_t frequency, bool (*callback)(void)) {
+    stepTimerInit(frequency, callback);
+    _dir_delay_us = dir_delay_us;
+    _pulse_us     = pulse_us ? pulse_us : 1;
+
+    __HAL_RCC_TIM8_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    // The prescaler divides by a whole number, so the counter runs at pulse_timer_hz or a
+    // little faster, 10.5 MHz from 168 MHz.  Count the pulse at the actual rate, rounding
+    // up, so that pulses are never shorter than pulse_us.
+    uint32_t prescale = pulse_timer_clock() / pulse_timer_hz;
+    uint32_t tick_hz  = pulse_timer_clock() / prescale;
+    uint32_t ticks    = uint32_t((uint64_t(_pulse_us) * tick_hz + 999999) / 1000000);
+
+    // One-pulse mode, so the counter stops after each pulse.  The compare outputs are
+    // frozen; only their DMA requests are used.
+    TIM8->CR1   = TIM_CR1_OPM | TIM_CR1_URS;
+    TIM8->CR2   = 0;
+    TIM8->DIER  = 0;
+    TIM8->CCMR1 = 0;
+    TIM8->CCMR2 = 0;
+    TIM8->CCER  = 0;
+    TIM8->PSC   = prescale - 1;
+    TIM8->ARR   = ticks + 1;
+    TIM8->CCR1  = ticks;
+    TIM8->CCR2  = ticks;
+    TIM8->CCR3  = ticks;
+    TIM8->CCR4  = ticks;
+    TIM8->EGR   = TIM_EGR_UG;  // Load the prescaler
+    TIM8->SR    = 0;
+
+    return _pulse_us;
+}
 
-static bool step_engine_initialized = false;
-static bool step_engine_enabled = false;
+// Returns the index of the DMA stream that ends the pulses on a GPIO port, setting
+// one up if the port has none yet, or -1 if all of them are in use
+static int port_index(GPIO_TypeDef* gpio) {
+    for (int i = 0; i < n_ports; i++) {
+        if (port_gpio[i] == gpio) {
+            return i;
+        }
+    }
+    if (n_ports == max_ports) {
+        return -1;
+    }
 
-// Step engine callback function
-static bool (*step_engine_callback)(void) = nullptr;
+    int i        = n_ports++;
+    port_gpio[i] = gpio;
+    port_end[i]  = 0;
+
+    auto& dma    = dma_ports[i];
+    auto  stream = dma.stream;
+    stream->CR   = 0;
+    while (stream->CR & DMA_SxCR_EN) {}
+    *dma.flag_clear = dma.flag_bits;
+    stream->PAR     = uint32_t(&gpio->BSRR);
+    stream->M0AR    = uint32_t(&port_end[i]);
+    stream->NDTR    = 1;
+    stream->FCR     = 0;  // Direct mode
+    stream->CR      = (7 << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_CIRC | DMA_SxCR_DIR_0 |
+                 DMA_SxCR_EN;
+    TIM8->DIER |= dma.cc_dma_enable;
+    return i;
+}
 
-// Initialize the step engine
-bool step_engine_init() {
-    if (!step_engine_initialized) {
-        // Initialize step engine hardware
-        step_engine_initialized = true;
-        step_engine_enabled = false;
+static int init_step_pin(int step_pin, int step_invert) {
+    if (n_step_pins == max_step_pins) {
+        log_error("Too many step pins");
+        return -1;
     }
-    return step_engine_initialized;
+    PinName name = PinName(step_pin);
+    int     port = port_index(get_GPIO_Port(STM_PORT(name)));
+    if (port < 0) {
+        log_error("Step pins are on more than " << max_ports << " GPIO ports");
+        return -1;
+    }
+    pinMode(name, OUTPUT);
+    digitalWriteFast(name, step_invert);  // Idle level, since the pulses end without an unstep
+
+    int id       = n_step_pins++;
+    pin_port[id] = port;
+    pin_mask[id] = uint32_t(1) << STM_PIN(name);
+    return id;
 }
 
-// Set the step engine callback
-void step_engine_set_callback(bool (*callback)(void)) {
-    step_engine_callback = callback;
+static void IRAM_ATTR set_dir_pin(int pin, int level) {
+    digitalWriteFast(PinName(pin), level);
 }
 
-// Enable the step engine
-void step_engine_enable() {
-    if (step_engine_initialized && !step_engine_enabled) {
-        step_engine_enabled = true;
-        // Initialize step timer with callback
-        if (step_engine_callback) {
-            stepTimerInit(1000000, step_engine_callback); // 1MHz base frequency
-        }
+static void IRAM_ATTR finish_dir() {
+    if (_dir_delay_us) {
+        delayMicroseconds(_dir_delay_us);
     }
 }
 
-// Disable the step engine
-void step_engine_disable() {
-    if (step_engine_enabled) {
-        stepTimerStop();
-        step_engine_enabled = false;
+static void IRAM_ATTR start_step() {
+    for (int i = 0; i < n_ports; i++) {
+        port_pulse[i] = 0;
     }
 }
 
-// Check if step engine is enabled
-bool step_engine_is_enabled() {
-    return step_engine_enabled;
+static void IRAM_ATTR set_step_pin(int pin, int level) {
+    if (pin < 0) {
+        return;
+    }
+    port_pulse[pin_port[pin]] |= level ? pin_mask[pin] : pin_mask[pin] << 16;
 }
 
-// Set step timing
-void step_engine_set_timing(uint32_t step_ticks) {
-    if (step_engine_enabled) {
-        stepTimerSetTicks(step_ticks);
+static void IRAM_ATTR write_step_pins(uint32_t pins, uint32_t levels) {
+    while (pins) {
+        int pin = __builtin_ctz(pins);
+        pins &= pins - 1;
+        set_step_pin(pin, (levels >> pin) & 1);
     }
 }
 
-// Start step generation
-void step_engine_start() {
-    if (step_engine_enabled) {
-        stepTimerStart();
+// Starts the pulses and the timer that ends them.  The end words swap the
+// halves of the start words, turning each set into a reset and vice versa.
+static void IRAM_ATTR finish_step() {
+    bool pulsing = false;
+    for (int i = 0; i < n_ports; i++) {
+        uint32_t pulse = port_pulse[i];
+        port_end[i]    = (pulse >> 16) | (pulse << 16);
+        if (pulse) {
+            port_gpio[i]->BSRR = pulse;
+            pulsing            = true;
+        }
+    }
+    if (pulsing) {
+        TIM8->CR1 |= TIM_CR1_CEN;
     }
 }
 
-// Stop step generation
-void step_engine_stop() {
-    if (step_engine_enabled) {
-        stepTimerStop();
-    }
+// The DMA ends the pulses, so Stepping.cpp can skip the unstep
+static int IRAM_ATTR start_unstep() {
+    return 1;
+}
+
+// Not called since start_unstep() returns 1
+static void IRAM_ATTR finish_unstep() {}
+
+static uint32_t max_pulses_per_sec() {
+    return 1000000 / (2 * _pulse_us);
+}
+
+static void IRAM_ATTR set_timer_ticks(uint32_t ticks) {
+    stepTimerSetTicks(ticks);
 }
 
-// Get current step count (if supported)
-uint32_t step_engine_get_steps() {
-    // This would need to be implemented based on the specific
-    // step counting mechanism used
-    return 0;
+static void IRAM_ATTR start_timer() {
+    stepTimerStart();
 }
 
-// Reset step count
-void step_engine_reset_steps() {
-    // Reset step counter if supported
+static void IRAM_ATTR stop_timer() {
+    stepTimerStop();
 }
 
-#endif // STM32
\ No newline at end of file
+// clang-format off
+static step_engine_t engine = {
+    "DMA",
+    init_engine,
+    init_step_pin,
+    set_dir_pin,
+    finish_dir,
+    start_step,
+    set_step_pin,
+    finish_step,
+    start_unstep,
+    finish_unstep,
+    max_pulses_per_sec,
+    set_timer_ticks,
+    start_timer,
+    stop_timer,
+    write_step_pins
+};
+// clang-format on
+
+REGISTER_STEP_ENGINE(DMA, &engine);
+
+#endif  // STM32
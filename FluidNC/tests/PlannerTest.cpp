@@ -0,0 +1,66 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#ifdef SIMULATOR
+
+#    include "gtest/gtest.h"
+#    include "SimMachine.h"
+
+#    include "src/Planner.h"
+#    include "src/Stepper.h"
+
+#    include <mutex>
+
+// Every block must be able to slow down from its entry speed to the entry speed of the
+// next block, and the newest block to a stop.
+static void expect_decelerations_within_limits() {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+    int                                   blocks = 0;
+    for (plan_block_t* block = plan_get_current_block(); block; block = plan_get_block(++blocks)) {
+        plan_block_t* next      = plan_get_block(blocks + 1);
+        float         exit_sqr  = next ? next->entry_speed_sqr : 0.0f;
+        float         reach_sqr = exit_sqr + 2 * block->acceleration * block->millimeters;
+        EXPECT_LE(block->entry_speed_sqr, reach_sqr * 1.001f) << "block " << blocks;
+    }
+    EXPECT_GT(blocks, 2);
+}
+
+// Blending a sharp corner shortens the block before it, so the blocks before that have to be
+// planned again.  Here the second block accelerates from the first, so it is already planned
+// when the corner is blended, and it has to slow down more to enter the shortened third block.
+TEST(Planner, BlendReplansEarlierBlocks) {
+    SimMachine::start();
+    ASSERT_EQ(SimMachine::run("G21 G91 G64 P1 Q0"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X2.8 F8000"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X1"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X2"), Error::Ok);
+    expect_decelerations_within_limits();
+    ASSERT_EQ(SimMachine::queue("G1 X-9.4 Y3.42"), Error::Ok);
+    expect_decelerations_within_limits();
+    ASSERT_EQ(SimMachine::run("G1 X3.6 Y-3.42"), Error::Ok);
+    ASSERT_EQ(SimMachine::run("G90 G61"), Error::Ok);
+}
+
+// The block before the shortened one enters at its maximum speed, which the reverse pass takes as
+// final, so that entry has to be cleared for the reverse pass to bring it down.
+TEST(Planner, BlendReplansBlocksAtMaximumEntry) {
+    SimMachine::start();
+    ASSERT_EQ(SimMachine::run("G21 G91 G64 P1 Q0"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X2.8 F8000"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X0.5 F1800"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X2 F8000"), Error::Ok);
+    expect_decelerations_within_limits();
+    ASSERT_EQ(SimMachine::queue("G1 X-9.4 Y3.42"), Error::Ok);
+    expect_decelerations_within_limits();
+    ASSERT_EQ(SimMachine::run("G1 X3.6 Y-3.42"), Error::Ok);
+    ASSERT_EQ(SimMachine::run("G90 G61"), Error::Ok);
+}
+
+TEST(Planner, NegativeTolerances) {
+    SimMachine::start();
+    EXPECT_EQ(SimMachine::run("G64 P-1"), Error::NegativeValue);
+    EXPECT_EQ(SimMachine::run("G64 Q-1"), Error::NegativeValue);
+    EXPECT_EQ(SimMachine::run("G61"), Error::Ok);
+}
+
+#endif
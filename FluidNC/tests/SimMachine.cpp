@@ -0,0 +1,104 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#ifdef SIMULATOR
+
+#    include "SimMachine.h"
+
+#    include "src/GCode.h"
+#    include "src/Protocol.h"
+#    include "src/State.h"
+#    include "sim/sim.h"
+
+#    include <gtest/gtest.h>
+
+#    include <cstdio>
+#    include <cstdlib>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+void setup();
+
+static const char* config_yaml = R"(name: Test XYZ
+board: Host simulator
+stepping:
+  engine: RMT
+  idle_ms: 255
+  pulse_us: 2
+  dir_delay_us: 1
+axes:
+  x:
+    steps_per_mm: 800
+    max_rate_mm_per_min: 8000
+    acceleration_mm_per_sec2: 200
+    max_travel_mm: 300
+    motor0:
+      standard_stepper:
+        step_pin: gpio.12
+        direction_pin: gpio.14
+  y:
+    steps_per_mm: 80
+    max_rate_mm_per_min: 5000
+    acceleration_mm_per_sec2: 200
+    max_travel_mm: 300
+    motor0:
+      standard_stepper:
+        step_pin: gpio.26
+        direction_pin: gpio.15
+  z:
+    steps_per_mm: 400
+    max_rate_mm_per_min: 1000
+    acceleration_mm_per_sec2: 100
+    max_travel_mm: 80
+    motor0:
+      standard_stepper:
+        step_pin: gpio.27
+        direction_pin: gpio.33
+)";
+
+namespace SimMachine {
+    void start() {
+        static bool started = false;
+        if (started) {
+            return;
+        }
+        started = true;
+
+        // The simulated local file system is littlefs/ in the current directory
+        char dir[] = "/tmp/fluidnc_testXXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        ASSERT_EQ(chdir(dir), 0);
+        ASSERT_EQ(mkdir("littlefs", 0755), 0);
+        FILE* f = fopen("littlefs/config.yaml", "w");
+        ASSERT_NE(f, nullptr);
+        fputs(config_yaml, f);
+        fclose(f);
+
+        // The firmware tasks keep running after the tests, so skip the static destructors
+        atexit([] {
+            fflush(stdout);
+            fflush(stderr);
+            _exit(0);
+        });
+
+        sim_speed = 100;
+        setup();
+        // Handle the start and restart events that setup() sends to the protocol loop
+        for (int i = 0; i < 2; i++) {
+            protocol_execute_realtime();
+        }
+        ASSERT_TRUE(state_is(State::Idle));
+    }
+
+    Error queue(const char* line) { return gc_execute_line(line); }
+
+    Error run(const char* line) {
+        Error err = queue(line);
+        protocol_buffer_synchronize();
+        return err;
+    }
+
+    uint64_t steps(int pin) { return sim_step_count(pin); }
+}
+
+#endif
@@ -0,0 +1,35 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Runs G-code through the whole motion pipeline on the host simulator, so
+// that tests can check the steps that reach the step pins.  Only the
+// tests_sim environment, which links the simulator, defines SIMULATOR.
+
+#ifdef SIMULATOR
+
+#    include "src/Error.h"
+
+#    include <cstdint>
+
+namespace SimMachine {
+    // Step pins of the test machine's axes, which have 800, 80 and 400 steps/mm
+    const int x_step_pin = 12;
+    const int y_step_pin = 26;
+    const int z_step_pin = 27;
+
+    // Starts the firmware with the test machine the first time it is called
+    void start();
+
+    // Executes a line of G-code, adding its motion to the planner
+    Error queue(const char* line);
+
+    // Executes a line of G-code and waits until all motion has finished
+    Error run(const char* line);
+
+    // Step pulses on a pin since start()
+    uint64_t steps(int pin);
+}
+
+#endif
@@ -0,0 +1,56 @@
+// Copyright (c) 2026 - FluidNC Contributors
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#ifdef SIMULATOR
+
+#    include "gtest/gtest.h"
+#    include "SimMachine.h"
+
+#    include "src/Stepping.h"
+#    include "src/Stepper.h"
+
+using Machine::Stepping;
+
+// Changes a stepping setting for one test and rebuilds the segment buffer
+class SteppingSetting {
+    uint32_t& _setting;
+    uint32_t  _saved;
+
+public:
+    SteppingSetting(uint32_t& setting, uint32_t value) : _setting(setting), _saved(setting) {
+        _setting = value;
+        Stepper::init();
+        Stepper::reset();
+    }
+    ~SteppingSetting() {
+        _setting = _saved;
+        Stepper::init();
+        Stepper::reset();
+    }
+};
+
+// At 800 steps/mm and F6000, a one second cruise segment has 80000 steps,
+// which does not fit in 16 bits
+TEST(Stepper, LongCruiseSegment) {
+    SimMachine::start();
+    SteppingSetting cruise(Stepping::_cruiseTicks, 1);
+
+    uint64_t before = SimMachine::steps(SimMachine::x_step_pin);
+    ASSERT_EQ(SimMachine::run("G21 G91 G1 X200 F6000"), Error::Ok);
+    ASSERT_EQ(SimMachine::run("G1 X-200"), Error::Ok);
+    EXPECT_EQ(SimMachine::steps(SimMachine::x_step_pin) - before, 320000);
+}
+
+// A pool of one block entry would leave the first block unloaded after a reset
+TEST(Stepper, OneSegmentBlock) {
+    SimMachine::start();
+    SteppingSetting blocks(Stepping::_segmentBlocks, 1);
+
+    uint64_t before = SimMachine::steps(SimMachine::x_step_pin);
+    ASSERT_EQ(SimMachine::queue("G21 G91 G1 X10 F3000"), Error::Ok);
+    ASSERT_EQ(SimMachine::queue("G1 X1 Y1"), Error::Ok);
+    ASSERT_EQ(SimMachine::run("G1 X-11 Y-1"), Error::Ok);
+    EXPECT_EQ(SimMachine::steps(SimMachine::x_step_pin) - before, 17600);
+}
+
+#endif
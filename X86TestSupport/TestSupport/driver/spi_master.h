@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Opaque in the ESP-IDF too; only pointers to it are ever used.
+typedef struct spi_device_t spi_device_t;
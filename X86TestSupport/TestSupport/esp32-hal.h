@@ -1,3 +1,7 @@
 #pragma once
 
 #include "esp32-hal-timer.h"
+
+inline void disableCore0WDT() {}
+
+const char* esp_get_idf_version(void);
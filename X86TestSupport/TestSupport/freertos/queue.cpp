@@ -1,4 +1,4 @@
-#include "Queue.h"
+#include "queue.h"
 
 #include <atomic>
 #include <vector>
@@ -57,6 +57,13 @@ BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue) {
     return pdTRUE;
 }
 
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+
+    auto used = xQueue->writeIndex + xQueue->data.size() - xQueue->readIndex;
+    return (used % xQueue->data.size()) / xQueue->entrySize;
+}
+
 BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void* const pvItemToQueue, TickType_t xTicksToWait, BaseType_t xCopyPosition) {
     return xQueueGenericSendFromISR(xQueue, pvItemToQueue, nullptr, xCopyPosition);
 }
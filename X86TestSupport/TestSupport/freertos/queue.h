@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Task.h"
+#include "task.h"
 #include "FreeRTOSTypes.h"
 
 #include <queue>
@@ -37,6 +37,8 @@ QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseTy
 
 BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue);
 
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+
 BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void* const pvItemToQueue, TickType_t xTicksToWait, BaseType_t xCopyPosition);
 
 #define xQueueSendFromISR(xQueue, pvItemToQueue, pxHigherPriorityTaskWoken)                                                                \
@@ -4,6 +4,8 @@
 #include "FreeRTOS.h"
 #include "FreeRTOSTypes.h"
 
+#include <climits>
+
 void vTaskDelay(const TickType_t xTicksToDelay);
 
 #define CONFIG_ARDUINO_RUNNING_CORE 0
@@ -31,6 +33,14 @@ void vTaskDelayUntil(TickType_t* const pxPreviousWakeTime, const TickType_t xTim
 
 TickType_t xTaskGetTickCount(void);
 
+void         vTaskSuspend(TaskHandle_t xTaskToSuspend);
+void         vTaskResume(TaskHandle_t xTaskToResume);
+void         vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void     vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken);
+
 #define CONFIG_FREERTOS_HZ 1000
 #define configTICK_RATE_HZ (CONFIG_FREERTOS_HZ)
 #define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <unordered_map>
 #include <string>
 #include "esp_err.h"
@@ -0,0 +1,4 @@
+#pragma once
+
+// The ESP-IDF generates sdkconfig.h from the project configuration.
+// None of the CONFIG_IDF_TARGET_* symbols are defined on the host.